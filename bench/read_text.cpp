@@ -0,0 +1,70 @@
+/*
+Benchmark for reading Text and CSV data blocks.
+
+Writes a segment with the given number of values (default: 10M) in text format
+and measures how long it takes to read its data back.
+
+    bench_read_text [n_values] [repetitions]
+*/
+#include <ovf.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+int main( int argc, char ** argv )
+{
+    long n_values   = argc > 1 ? std::atol( argv[1] ) : 10000000;
+    int repetitions = argc > 2 ? std::atoi( argv[2] ) : 3;
+    const char * filename = "bench_read_text.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim   = 3;
+    segment->n_cells[0] = int( std::max( 1L, n_values / 3 ) );
+    segment->n_cells[1] = 1;
+    segment->n_cells[2] = 1;
+    segment->N          = segment->n_cells[0];
+    n_values = 3L * segment->N;
+
+    std::vector<double> field( n_values );
+    for( long i = 0; i < n_values; ++i )
+        field[i] = ( i % 1000 - 500 ) * 0.001234567 + i * 1e-7;
+
+    auto file = ovf_open( filename );
+    auto t_write = std::chrono::steady_clock::now();
+    if( ovf_write_segment_8( file, segment, field.data(), OVF_FORMAT_TEXT ) != OVF_OK )
+    {
+        std::fprintf( stderr, "write failed: %s\n", ovf_latest_message( file ) );
+        return 1;
+    }
+    double write_ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t_write ).count();
+    ovf_close( file );
+    std::printf( "wrote %ld values in %.1f ms\n", n_values, write_ms );
+
+    std::vector<double> field_read( n_values );
+    double best_ms = 0;
+    for( int rep = 0; rep < repetitions; ++rep )
+    {
+        auto t_read = std::chrono::steady_clock::now();
+        file = ovf_open( filename );
+        auto segment_read = ovf_segment_create();
+        if( ovf_read_segment_header( file, 0, segment_read ) != OVF_OK ||
+            ovf_read_segment_data_8( file, 0, segment_read, field_read.data() ) != OVF_OK )
+        {
+            std::fprintf( stderr, "read failed: %s\n", ovf_latest_message( file ) );
+            return 1;
+        }
+        ovf_close( file );
+        double read_ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - t_read ).count();
+        if( rep == 0 || read_ms < best_ms )
+            best_ms = read_ms;
+    }
+
+    std::printf( "read %ld values in %.1f ms (best of %d), %.1f Mvalues/s\n",
+        n_values, best_ms, repetitions, n_values / best_ms / 1e3 );
+
+    std::remove( filename );
+    return 0;
+}
@@ -3,6 +3,18 @@
 #define LIBOVF_DETAIL_HELPERS_H
 
 #include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+// Byte order of the host, if it can be determined at compile time
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    #define LIBOVF_LITTLE_ENDIAN 1
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    #define LIBOVF_LITTLE_ENDIAN 0
+#elif defined(_WIN32)
+    #define LIBOVF_LITTLE_ENDIAN 1
+#endif
 
 namespace ovf
 {
@@ -18,16 +30,18 @@ namespace check
 
 namespace endian
 {
-    // union
-    // {
-    //     uint16_t s;
-    //     unsigned char c[2];
-    // } constexpr static  d {1};
-
-    // constexpr bool is_little()
-    // {
-    //     return d.c[0] == 1;
-    // }
+    // Whether the host stores values in little endian byte order, i.e. the same as OVF binary data
+    inline bool is_little()
+    {
+    #ifdef LIBOVF_LITTLE_ENDIAN
+        return LIBOVF_LITTLE_ENDIAN;
+    #else
+        const uint16_t one = 1;
+        unsigned char c[2];
+        std::memcpy( c, &one, 2 );
+        return c[0] == 1;
+    #endif
+    }
 
     inline uint32_t from_little_32(const uint8_t * bytes)
     {
@@ -70,6 +84,153 @@ namespace endian
         bytes[6] = in >> 48;
         bytes[7] = in >> 56;
     }
+
+    /*
+    Bulk conversion between arrays of scalars and little endian IEEE 754 binary32/binary64 data.
+    On little endian hosts the bytes are already in the right order, so this is a plain memcpy when the
+    scalar type matches and a straight (vectorizable) conversion loop otherwise.
+    Only big endian hosts need to swap bytes, which is done with the shift-based functions above.
+    The byte arrays do not need to be aligned.
+    */
+    template<typename scalar>
+    inline void from_little_32_array( const uint8_t * bytes, scalar * out, std::size_t n )
+    {
+        if( is_little() && std::is_same<scalar, float>::value )
+            std::memcpy( out, bytes, 4*n );
+        else if( is_little() )
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                float value;
+                std::memcpy( &value, bytes + 4*i, 4 );
+                out[i] = value;
+            }
+        }
+        else
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                uint32_t ivalue = from_little_32( bytes + 4*i );
+                float value;
+                std::memcpy( &value, &ivalue, 4 );
+                out[i] = value;
+            }
+        }
+    }
+
+    template<typename scalar>
+    inline void from_little_64_array( const uint8_t * bytes, scalar * out, std::size_t n )
+    {
+        if( is_little() && std::is_same<scalar, double>::value )
+            std::memcpy( out, bytes, 8*n );
+        else if( is_little() )
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                double value;
+                std::memcpy( &value, bytes + 8*i, 8 );
+                out[i] = static_cast<scalar>( value );
+            }
+        }
+        else
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                uint64_t ivalue = from_little_64( bytes + 8*i );
+                double value;
+                std::memcpy( &value, &ivalue, 8 );
+                out[i] = static_cast<scalar>( value );
+            }
+        }
+    }
+
+    /*
+    Strided gather variants: value i is read from bytes + i*byte_stride and stored to out[i*out_stride],
+    e.g. to pick one component out of every cell.
+    */
+    template<typename scalar>
+    inline void from_little_32_gather( const uint8_t * bytes, std::size_t byte_stride, scalar * out, std::size_t out_stride, std::size_t n )
+    {
+        for( std::size_t i = 0; i < n; ++i )
+        {
+            float value;
+            if( is_little() )
+                std::memcpy( &value, bytes + i*byte_stride, 4 );
+            else
+            {
+                uint32_t ivalue = from_little_32( bytes + i*byte_stride );
+                std::memcpy( &value, &ivalue, 4 );
+            }
+            out[i*out_stride] = static_cast<scalar>( value );
+        }
+    }
+
+    template<typename scalar>
+    inline void from_little_64_gather( const uint8_t * bytes, std::size_t byte_stride, scalar * out, std::size_t out_stride, std::size_t n )
+    {
+        for( std::size_t i = 0; i < n; ++i )
+        {
+            double value;
+            if( is_little() )
+                std::memcpy( &value, bytes + i*byte_stride, 8 );
+            else
+            {
+                uint64_t ivalue = from_little_64( bytes + i*byte_stride );
+                std::memcpy( &value, &ivalue, 8 );
+            }
+            out[i*out_stride] = static_cast<scalar>( value );
+        }
+    }
+
+    template<typename scalar>
+    inline void to_little_32_array( const scalar * in, uint8_t * bytes, std::size_t n )
+    {
+        if( is_little() && std::is_same<scalar, float>::value )
+            std::memcpy( bytes, in, 4*n );
+        else if( is_little() )
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                float value = static_cast<float>( in[i] );
+                std::memcpy( bytes + 4*i, &value, 4 );
+            }
+        }
+        else
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                float value = static_cast<float>( in[i] );
+                uint32_t ivalue;
+                std::memcpy( &ivalue, &value, 4 );
+                to_little_32( ivalue, bytes + 4*i );
+            }
+        }
+    }
+
+    template<typename scalar>
+    inline void to_little_64_array( const scalar * in, uint8_t * bytes, std::size_t n )
+    {
+        if( is_little() && std::is_same<scalar, double>::value )
+            std::memcpy( bytes, in, 8*n );
+        else if( is_little() )
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                double value = static_cast<double>( in[i] );
+                std::memcpy( bytes + 8*i, &value, 8 );
+            }
+        }
+        else
+        {
+            for( std::size_t i = 0; i < n; ++i )
+            {
+                double value = static_cast<double>( in[i] );
+                uint64_t ivalue;
+                std::memcpy( &ivalue, &value, 8 );
+                to_little_64( ivalue, bytes + 8*i );
+            }
+        }
+    }
 }
 }
 }
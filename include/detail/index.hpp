@@ -0,0 +1,295 @@
+#pragma once
+#ifndef LIBOVF_DETAIL_INDEX_H
+#define LIBOVF_DETAIL_INDEX_H
+
+#include "ovf.h"
+#include <detail/io.hpp>
+#include <detail/parse_rules.hpp>
+
+#include <fmt/format.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace ovf
+{
+namespace detail
+{
+namespace index
+{
+    /*
+    The sidecar index file stores the segment index of an OVF file next to it, together with the
+    parsed segment headers, so that reopening a large file does not require scanning it again
+    and reading a segment header does not require parsing it.
+    It is only used if the size and modification time of the OVF file match the ones recorded in it.
+
+    Layout (plain text):
+        # OVF segment index: <format version>
+        # file size: <bytes>
+        # file mtime: <mtime>
+        # segment count: <segment count in the file header>
+        # segment count position: <byte offset of the segment count>
+        # indexed segments: <number of lines following>
+        <begin> <end> <header_begin> <header_end> <data_begin> <data_end> <payload_begin> <format> <valuedim> <xnodes> <ynodes> <znodes> <pointcount> <N> <has header>
+        ...
+    If the header of a segment is stored (<has header> is 1), its line continues with
+        <found comment> <found valuedim> <valuedim> <xnodes> <ynodes> <znodes> <pointcount> <N>
+        <bounds_min, bounds_max, origin and step_size as the bits of 12 floats> <lengths of the 6 strings>
+    and is followed by a line holding the title, comment, valueunits, valuelabels, meshtype and meshunit
+    one after the other, without separators.
+    */
+    static const int sidecar_version = 2;
+
+    // Floats are stored as their bits, so that they are restored exactly
+    inline unsigned long long float_bits( float value )
+    {
+        uint32_t bits;
+        std::memcpy( &bits, &value, sizeof(bits) );
+        return bits;
+    }
+
+    inline float bits_float( unsigned long long value )
+    {
+        uint32_t bits = uint32_t( value );
+        float result;
+        std::memcpy( &result, &bits, sizeof(bits) );
+        return result;
+    }
+
+    // "file.ovf" -> "file.ovfidx", any other name gets ".ovfidx" appended
+    inline std::string sidecar_filename( const std::string & filename )
+    {
+        const std::string ext = ".ovf";
+        if( filename.size() > ext.size() && filename.compare( filename.size() - ext.size(), ext.size(), ext ) == 0 )
+            return filename + "idx";
+        return filename + ".ovfidx";
+    }
+
+    // Parse one unsigned integer from a sidecar line, advancing the pointer
+    inline bool read_number( const char *& pos, const char * end, unsigned long long & value )
+    {
+        while( pos < end && ( *pos == ' ' || *pos == '\t' ) )
+            ++pos;
+        if( pos >= end || *pos < '0' || *pos > '9' )
+            return false;
+        value = 0;
+        while( pos < end && *pos >= '0' && *pos <= '9' )
+            value = 10*value + ( *pos++ - '0' );
+        return true;
+    }
+
+    // Parse a "# <label>: <number>" line, advancing the pointer to the next line
+    inline bool read_field( const char *& pos, const char * end, const std::string & label, unsigned long long & value )
+    {
+        std::string prefix = "# " + label + ":";
+        if( std::size_t(end - pos) < prefix.size() || std::string( pos, prefix.size() ) != prefix )
+            return false;
+        pos += prefix.size();
+        if( !read_number( pos, end, value ) )
+            return false;
+        while( pos < end && *pos != '\n' )
+            ++pos;
+        if( pos < end )
+            ++pos;
+        return true;
+    }
+
+    /*
+    Load the segment index of a file from its sidecar, if it exists and matches the file.
+    The file header needs to be parsed already. Returns false if the sidecar is missing, stale or broken,
+    in which case the index needs to be built by scanning the file.
+    */
+    inline bool load( ovf_file & file )
+    try
+    {
+        io::file_status status;
+        if( !io::get_file_status( file.file_name, status ) )
+            return false;
+
+        std::ifstream stream( sidecar_filename( file.file_name ), std::ios::binary );
+        if( !stream.is_open() )
+            return false;
+        std::stringstream buffer;
+        buffer << stream.rdbuf();
+        const std::string contents = buffer.str();
+        const char * pos = contents.data();
+        const char * end = contents.data() + contents.size();
+
+        unsigned long long version = 0, size = 0, mtime = 0, n_segments = 0, n_segments_pos = 0, n_indexed = 0;
+        if( !read_field( pos, end, "OVF segment index", version ) || version != sidecar_version )
+            return false;
+        if( !read_field( pos, end, "file size", size ) || size != status.size )
+            return false;
+        if( !read_field( pos, end, "file mtime", mtime ) || (long long)mtime != status.mtime )
+            return false;
+        if( !read_field( pos, end, "segment count", n_segments ) || (int)n_segments != file.n_segments )
+            return false;
+        if( !read_field( pos, end, "segment count position", n_segments_pos ) ||
+            n_segments_pos != (unsigned long long)file._state->n_segments_pos )
+            return false;
+        if( !read_field( pos, end, "indexed segments", n_indexed ) )
+            return false;
+
+        std::vector<segment_index_entry> segment_index( n_indexed );
+        for( auto & entry : segment_index )
+        {
+            unsigned long long v[14];
+            for( int i = 0; i < 14; ++i )
+            {
+                if( !read_number( pos, end, v[i] ) )
+                    return false;
+            }
+
+            entry.begin         = v[0];
+            entry.end           = v[1];
+            entry.header_begin  = v[2];
+            entry.header_end    = v[3];
+            entry.data_begin    = v[4];
+            entry.data_end      = v[5];
+            entry.payload_begin = v[6];
+            entry.format        = int(v[7]) - 1;
+            entry.valuedim      = int(v[8]);
+            entry.n_cells[0]    = int(v[9]);
+            entry.n_cells[1]    = int(v[10]);
+            entry.n_cells[2]    = int(v[11]);
+            entry.pointcount    = int(v[12]);
+            entry.N             = int(v[13]);
+
+            if( entry.end > status.size )
+                return false;
+
+            unsigned long long has_header = 0;
+            if( !read_number( pos, end, has_header ) )
+                return false;
+            if( has_header )
+            {
+                unsigned long long h[26];
+                for( int i = 0; i < 26; ++i )
+                {
+                    if( !read_number( pos, end, h[i] ) )
+                        return false;
+                }
+                if( pos >= end || *pos != '\n' )
+                    return false;
+                ++pos;
+
+                std::shared_ptr<segment_header_fields> fields( new segment_header_fields() );
+                fields->found_comment  = h[0] != 0;
+                fields->found_valuedim = h[1] != 0;
+                fields->valuedim       = int(uint32_t(h[2]));
+                fields->n_cells[0]     = int(uint32_t(h[3]));
+                fields->n_cells[1]     = int(uint32_t(h[4]));
+                fields->n_cells[2]     = int(uint32_t(h[5]));
+                fields->pointcount     = int(uint32_t(h[6]));
+                fields->N              = int(uint32_t(h[7]));
+                for( int dim = 0; dim < 3; ++dim )
+                {
+                    fields->bounds_min[dim] = bits_float( h[8 + dim] );
+                    fields->bounds_max[dim] = bits_float( h[11 + dim] );
+                    fields->origin[dim]     = bits_float( h[14 + dim] );
+                    fields->step_size[dim]  = bits_float( h[17 + dim] );
+                }
+                std::string * strings[6] = { &fields->title, &fields->comment, &fields->valueunits,
+                    &fields->valuelabels, &fields->meshtype, &fields->meshunit };
+                for( int i = 0; i < 6; ++i )
+                {
+                    if( h[20 + i] > std::size_t(end - pos) )
+                        return false;
+                    strings[i]->assign( pos, std::size_t(h[20 + i]) );
+                    pos += h[20 + i];
+                }
+                entry.header = fields;
+            }
+            if( pos < end && *pos == '\n' )
+                ++pos;
+        }
+
+        file._state->segment_index.swap( segment_index );
+        return true;
+    }
+    catch( ... )
+    {
+        return false;
+    }
+
+    /*
+    Write the segment index of a file into its sidecar.
+    Failing to write it (e.g. in a read-only directory) is not an error, the file is simply scanned next time.
+    */
+    inline void save( ovf_file & file )
+    try
+    {
+        io::file_status status;
+        if( !io::get_file_status( file.file_name, status ) )
+            return;
+
+        fmt::memory_buffer buffer;
+        fmt::format_to( buffer, "# OVF segment index: {}\n", sidecar_version );
+        fmt::format_to( buffer, "# file size: {}\n", status.size );
+        fmt::format_to( buffer, "# file mtime: {}\n", status.mtime );
+        fmt::format_to( buffer, "# segment count: {}\n", file.n_segments );
+        fmt::format_to( buffer, "# segment count position: {}\n", (unsigned long long)file._state->n_segments_pos );
+        fmt::format_to( buffer, "# indexed segments: {}\n", file._state->segment_index.size() );
+        for( const auto & entry : file._state->segment_index )
+        {
+            // The format is stored shifted by one, so that "no data block" (-1) is not negative
+            fmt::format_to( buffer, "{} {} {} {} {} {} {} {} {} {} {} {} {} {} {}",
+                entry.begin, entry.end, entry.header_begin, entry.header_end,
+                entry.data_begin, entry.data_end, entry.payload_begin, entry.format + 1,
+                entry.valuedim, entry.n_cells[0], entry.n_cells[1], entry.n_cells[2],
+                entry.pointcount, entry.N, entry.header ? 1 : 0 );
+            if( entry.header )
+            {
+                const segment_header_fields & fields = *entry.header;
+                fmt::format_to( buffer, " {} {} {} {} {} {} {} {}",
+                    int(fields.found_comment), int(fields.found_valuedim), uint32_t(fields.valuedim),
+                    uint32_t(fields.n_cells[0]), uint32_t(fields.n_cells[1]), uint32_t(fields.n_cells[2]),
+                    uint32_t(fields.pointcount), uint32_t(fields.N) );
+                for( const float * values : { fields.bounds_min, fields.bounds_max, fields.origin, fields.step_size } )
+                    fmt::format_to( buffer, " {} {} {}", float_bits(values[0]), float_bits(values[1]), float_bits(values[2]) );
+                fmt::format_to( buffer, " {} {} {} {} {} {}\n{}{}{}{}{}{}",
+                    fields.title.size(), fields.comment.size(), fields.valueunits.size(),
+                    fields.valuelabels.size(), fields.meshtype.size(), fields.meshunit.size(),
+                    fields.title, fields.comment, fields.valueunits,
+                    fields.valuelabels, fields.meshtype, fields.meshunit );
+            }
+            fmt::format_to( buffer, "\n" );
+        }
+
+        // Write to a temporary file first, so that readers never see a partially written sidecar
+        const std::string sidecar = sidecar_filename( file.file_name );
+        const std::string tmp = sidecar + ".tmp";
+        {
+            std::ofstream stream( tmp, std::ios::binary | std::ios::trunc );
+            if( !stream.is_open() )
+                return;
+            stream.write( buffer.data(), buffer.size() );
+            if( !stream.good() )
+            {
+                stream.close();
+                std::remove( tmp.c_str() );
+                return;
+            }
+        }
+        if( std::rename( tmp.c_str(), sidecar.c_str() ) != 0 )
+        {
+            // std::rename does not replace existing files on all platforms
+            std::remove( sidecar.c_str() );
+            if( std::rename( tmp.c_str(), sidecar.c_str() ) != 0 )
+                std::remove( tmp.c_str() );
+        }
+    }
+    catch( ... )
+    {
+    }
+}
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,573 @@
+#pragma once
+#ifndef LIBOVF_DETAIL_IO_H
+#define LIBOVF_DETAIL_IO_H
+
+#include <string>
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/uio.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace ovf
+{
+namespace detail
+{
+namespace io
+{
+    // Size and modification time of a file, used to tell whether a file has changed
+    struct file_status
+    {
+        std::size_t size = 0;
+        // Nanoseconds (or the best available resolution) since an arbitrary epoch
+        long long mtime  = 0;
+    };
+
+    // Query the status of a file. Returns false if the file cannot be accessed
+    inline bool get_file_status( const std::string & filename, file_status & status )
+    {
+    #ifdef _WIN32
+        WIN32_FILE_ATTRIBUTE_DATA attributes;
+        if( !GetFileAttributesExA( filename.c_str(), GetFileExInfoStandard, &attributes ) )
+            return false;
+        status.size = static_cast<std::size_t>(
+            ( static_cast<unsigned long long>( attributes.nFileSizeHigh ) << 32 ) | attributes.nFileSizeLow );
+        status.mtime = static_cast<long long>(
+            ( static_cast<unsigned long long>( attributes.ftLastWriteTime.dwHighDateTime ) << 32 )
+            | attributes.ftLastWriteTime.dwLowDateTime ) * 100;
+        return true;
+    #else
+        struct stat file_stat;
+        if( ::stat( filename.c_str(), &file_stat ) != 0 )
+            return false;
+        status.size = static_cast<std::size_t>( file_stat.st_size );
+    #if defined(__APPLE__)
+        status.mtime = static_cast<long long>( file_stat.st_mtimespec.tv_sec ) * 1000000000LL + file_stat.st_mtimespec.tv_nsec;
+    #else
+        status.mtime = static_cast<long long>( file_stat.st_mtim.tv_sec ) * 1000000000LL + file_stat.st_mtim.tv_nsec;
+    #endif
+        return true;
+    #endif
+    }
+
+    // Size of a file in bytes. Returns false if the file cannot be accessed
+    inline bool file_size( const std::string & filename, std::size_t & size )
+    {
+        file_status status;
+        if( !get_file_status( filename, status ) )
+            return false;
+        size = status.size;
+        return true;
+    }
+
+
+    /*
+    Read-only memory mapping of an entire file.
+    The parser works directly on the mapped bytes, so that opening and reading a file
+    does not copy its contents onto the heap. The pages are served from the page cache.
+    */
+    class file_mapping
+    {
+    public:
+        file_mapping() = default;
+        ~file_mapping();
+
+        file_mapping( const file_mapping & ) = delete;
+        file_mapping & operator=( const file_mapping & ) = delete;
+
+        // Map the given file, replacing any previous mapping. Returns false if the file cannot be mapped
+        bool open( const std::string & filename );
+        // Unmap the file. This needs to happen before the file is truncated
+        void close();
+
+        // Exchange the mappings of two objects, e.g. to keep an old mapping alive while remapping
+        void swap( file_mapping & other );
+
+        bool is_open() const { return mapped; }
+        const char * data() const { return mapped_data; }
+        std::size_t size() const { return mapped_size; }
+
+    private:
+        bool mapped              = false;
+        const char * mapped_data = nullptr;
+        std::size_t mapped_size  = 0;
+    #ifdef _WIN32
+        HANDLE file_handle    = INVALID_HANDLE_VALUE;
+        HANDLE mapping_handle = NULL;
+    #endif
+    };
+
+
+    inline file_mapping::~file_mapping()
+    {
+        close();
+    }
+
+
+    inline bool file_mapping::open( const std::string & filename )
+    {
+        close();
+
+        // An empty file cannot be mapped, but is still a valid (empty) input
+        static const char empty[1] = { '\0' };
+
+    #ifdef _WIN32
+        file_handle = CreateFileA( filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        if( file_handle == INVALID_HANDLE_VALUE )
+            return false;
+
+        LARGE_INTEGER file_size;
+        if( !GetFileSizeEx( file_handle, &file_size ) )
+        {
+            close();
+            return false;
+        }
+
+        if( file_size.QuadPart == 0 )
+        {
+            mapped_data = empty;
+            mapped_size = 0;
+            mapped      = true;
+            return true;
+        }
+
+        mapping_handle = CreateFileMappingA( file_handle, NULL, PAGE_READONLY, 0, 0, NULL );
+        if( mapping_handle == NULL )
+        {
+            close();
+            return false;
+        }
+
+        void * view = MapViewOfFile( mapping_handle, FILE_MAP_READ, 0, 0, 0 );
+        if( view == NULL )
+        {
+            close();
+            return false;
+        }
+
+        mapped_data = static_cast<const char *>( view );
+        mapped_size = static_cast<std::size_t>( file_size.QuadPart );
+        mapped      = true;
+        return true;
+    #else
+        int fd = ::open( filename.c_str(), O_RDONLY );
+        if( fd < 0 )
+            return false;
+
+        struct stat file_stat;
+        if( ::fstat( fd, &file_stat ) != 0 )
+        {
+            ::close( fd );
+            return false;
+        }
+
+        if( file_stat.st_size == 0 )
+        {
+            ::close( fd );
+            mapped_data = empty;
+            mapped_size = 0;
+            mapped      = true;
+            return true;
+        }
+
+        std::size_t size = static_cast<std::size_t>( file_stat.st_size );
+        void * view = ::mmap( nullptr, size, PROT_READ, MAP_SHARED, fd, 0 );
+        // The mapping stays valid after the descriptor is closed
+        ::close( fd );
+        if( view == MAP_FAILED )
+            return false;
+
+        mapped_data = static_cast<const char *>( view );
+        mapped_size = size;
+        mapped      = true;
+        return true;
+    #endif
+    }
+
+
+    inline void file_mapping::swap( file_mapping & other )
+    {
+        std::swap( mapped, other.mapped );
+        std::swap( mapped_data, other.mapped_data );
+        std::swap( mapped_size, other.mapped_size );
+    #ifdef _WIN32
+        std::swap( file_handle, other.file_handle );
+        std::swap( mapping_handle, other.mapping_handle );
+    #endif
+    }
+
+
+    inline void file_mapping::close()
+    {
+    #ifdef _WIN32
+        if( mapped && mapped_size > 0 )
+            UnmapViewOfFile( mapped_data );
+        if( mapping_handle != NULL )
+            CloseHandle( mapping_handle );
+        if( file_handle != INVALID_HANDLE_VALUE )
+            CloseHandle( file_handle );
+        mapping_handle = NULL;
+        file_handle    = INVALID_HANDLE_VALUE;
+    #else
+        if( mapped && mapped_size > 0 )
+            ::munmap( const_cast<char *>( mapped_data ), mapped_size );
+    #endif
+        mapped      = false;
+        mapped_data = nullptr;
+        mapped_size = 0;
+    }
+
+
+    // A range of bytes to be written
+    struct buffer_view
+    {
+        const char * data;
+        std::size_t size;
+    };
+
+
+    /*
+    Unbuffered output to a file through a plain descriptor.
+    Buffering is left to the caller, which writes in large chunks.
+    */
+    class file_writer
+    {
+    public:
+        file_writer() = default;
+        ~file_writer();
+
+        file_writer( const file_writer & ) = delete;
+        file_writer & operator=( const file_writer & ) = delete;
+
+        // Open the file for writing, either truncating it or appending to its end. Returns false on failure
+        bool open( const std::string & filename, bool append );
+        void close();
+
+        bool is_open() const;
+        // Write all of the given bytes at the end of the file. Returns false on failure
+        bool write( const char * data, std::size_t size );
+        // Write several buffers one after the other, with a single system call where possible (writev)
+        bool write( const buffer_view * buffers, std::size_t count );
+        // Overwrite bytes at the given offset, without moving the position of the next write (pwrite)
+        bool write_at( std::size_t offset, const char * data, std::size_t size );
+        /*
+        Allocate the disk space for bytes which are about to be written at the given offset, so that the
+        file system can place them in few extents. The size of the file is not changed. This is only a hint,
+        it does nothing where it is not supported.
+        */
+        void preallocate( std::size_t offset, std::size_t size );
+        // Flush the written data to the storage device (fdatasync). Returns false on failure
+        bool sync();
+        // Cut the file off at the given size, so that the next write ends up there. Returns false on failure
+        bool truncate( std::size_t size );
+        // Offset in the file at which the next write ends up
+        std::size_t position() const { return file_position; }
+
+    private:
+        std::size_t file_position = 0;
+    #ifdef _WIN32
+        HANDLE file_handle = INVALID_HANDLE_VALUE;
+    #else
+        int fd = -1;
+    #endif
+    };
+
+
+    inline file_writer::~file_writer()
+    {
+        close();
+    }
+
+
+    inline bool file_writer::open( const std::string & filename, bool append )
+    {
+        close();
+        file_position = 0;
+
+    #ifdef _WIN32
+        file_handle = CreateFileA( filename.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            NULL, append ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+        if( file_handle == INVALID_HANDLE_VALUE )
+            return false;
+
+        LARGE_INTEGER zero, end;
+        zero.QuadPart = 0;
+        if( !SetFilePointerEx( file_handle, zero, &end, FILE_END ) )
+        {
+            close();
+            return false;
+        }
+        file_position = static_cast<std::size_t>( end.QuadPart );
+        return true;
+    #else
+        // Not O_APPEND, as Linux ignores the offset of pwrite on such descriptors
+        int flags = O_WRONLY | O_CREAT | ( append ? 0 : O_TRUNC );
+        do
+        {
+            fd = ::open( filename.c_str(), flags, 0666 );
+        } while( fd < 0 && errno == EINTR );
+        if( fd < 0 )
+            return false;
+
+        off_t end = ::lseek( fd, 0, SEEK_END );
+        if( end < 0 )
+        {
+            close();
+            return false;
+        }
+        file_position = static_cast<std::size_t>( end );
+        return true;
+    #endif
+    }
+
+
+    inline void file_writer::close()
+    {
+    #ifdef _WIN32
+        if( file_handle != INVALID_HANDLE_VALUE )
+            CloseHandle( file_handle );
+        file_handle = INVALID_HANDLE_VALUE;
+    #else
+        if( fd >= 0 )
+            ::close( fd );
+        fd = -1;
+    #endif
+    }
+
+
+    inline bool file_writer::is_open() const
+    {
+    #ifdef _WIN32
+        return file_handle != INVALID_HANDLE_VALUE;
+    #else
+        return fd >= 0;
+    #endif
+    }
+
+
+    inline bool file_writer::write( const char * data, std::size_t size )
+    {
+        if( !is_open() )
+            return false;
+
+        while( size > 0 )
+        {
+        #ifdef _WIN32
+            DWORD chunk = static_cast<DWORD>( size < 0x40000000 ? size : 0x40000000 );
+            DWORD written = 0;
+            if( !WriteFile( file_handle, data, chunk, &written, NULL ) || written == 0 )
+                return false;
+        #else
+            ssize_t written = ::write( fd, data, size );
+            if( written < 0 && errno == EINTR )
+                continue;
+            if( written <= 0 )
+                return false;
+        #endif
+            data          += written;
+            size          -= static_cast<std::size_t>( written );
+            file_position += static_cast<std::size_t>( written );
+        }
+        return true;
+    }
+
+
+    inline bool file_writer::write_at( std::size_t offset, const char * data, std::size_t size )
+    {
+        if( !is_open() )
+            return false;
+
+        while( size > 0 )
+        {
+        #ifdef _WIN32
+            DWORD chunk = static_cast<DWORD>( size < 0x40000000 ? size : 0x40000000 );
+            DWORD written = 0;
+            OVERLAPPED overlapped = {};
+            overlapped.Offset     = static_cast<DWORD>( offset & 0xFFFFFFFF );
+            overlapped.OffsetHigh = static_cast<DWORD>( static_cast<unsigned long long>( offset ) >> 32 );
+            bool success = WriteFile( file_handle, data, chunk, &written, &overlapped ) && written > 0;
+            // On a synchronous handle this moves the file pointer, which has to be restored
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>( file_position );
+            if( !SetFilePointerEx( file_handle, end, NULL, FILE_BEGIN ) || !success )
+                return false;
+        #else
+            ssize_t written = ::pwrite( fd, data, size, static_cast<off_t>( offset ) );
+            if( written < 0 && errno == EINTR )
+                continue;
+            if( written <= 0 )
+                return false;
+        #endif
+            data   += written;
+            size   -= static_cast<std::size_t>( written );
+            offset += static_cast<std::size_t>( written );
+        }
+        return true;
+    }
+
+
+    inline void file_writer::preallocate( std::size_t offset, std::size_t size )
+    {
+        if( !is_open() || size == 0 )
+            return;
+
+    #if defined(_WIN32)
+        // The allocation size is kept separately from the end of the file
+        FILE_ALLOCATION_INFO allocation;
+        allocation.AllocationSize.QuadPart = static_cast<LONGLONG>( offset + size );
+        SetFileInformationByHandle( file_handle, FileAllocationInfo, &allocation, sizeof(allocation) );
+    #elif defined(__linux__)
+        // Not posix_fallocate, which changes the file size and may fall back to writing zeros
+        int result = 0;
+        do
+        {
+            result = ::fallocate( fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>( offset ), static_cast<off_t>( size ) );
+        } while( result != 0 && errno == EINTR );
+    #else
+        (void)offset;
+    #endif
+    }
+
+
+    inline bool file_writer::sync()
+    {
+        if( !is_open() )
+            return false;
+
+    #if defined(_WIN32)
+        return FlushFileBuffers( file_handle ) != 0;
+    #elif defined(__linux__)
+        int result = 0;
+        do
+        {
+            result = ::fdatasync( fd );
+        } while( result != 0 && errno == EINTR );
+        return result == 0;
+    #else
+        int result = 0;
+        do
+        {
+            result = ::fsync( fd );
+        } while( result != 0 && errno == EINTR );
+        return result == 0;
+    #endif
+    }
+
+
+    inline bool file_writer::truncate( std::size_t size )
+    {
+        if( !is_open() )
+            return false;
+
+    #ifdef _WIN32
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>( size );
+        if( !SetFilePointerEx( file_handle, end, NULL, FILE_BEGIN ) || !SetEndOfFile( file_handle ) )
+            return false;
+    #else
+        if( ::ftruncate( fd, static_cast<off_t>( size ) ) != 0 || ::lseek( fd, static_cast<off_t>( size ), SEEK_SET ) < 0 )
+            return false;
+    #endif
+        file_position = size;
+        return true;
+    }
+
+
+    // Flush the directory entry of a newly created file to the storage device. Returns false on failure
+    inline bool sync_directory( const std::string & filename )
+    {
+    #ifdef _WIN32
+        // Directory entries are flushed together with the file
+        (void)filename;
+        return true;
+    #else
+        std::string::size_type slash = filename.find_last_of( '/' );
+        std::string directory = slash == std::string::npos ? "." : ( slash == 0 ? "/" : filename.substr( 0, slash ) );
+        int fd = -1;
+        do
+        {
+            fd = ::open( directory.c_str(), O_RDONLY );
+        } while( fd < 0 && errno == EINTR );
+        if( fd < 0 )
+            return false;
+        int result = 0;
+        do
+        {
+            result = ::fsync( fd );
+        } while( result != 0 && errno == EINTR );
+        ::close( fd );
+        return result == 0;
+    #endif
+    }
+
+
+    inline bool file_writer::write( const buffer_view * buffers, std::size_t count )
+    {
+    #ifdef _WIN32
+        for( std::size_t i = 0; i < count; ++i )
+        {
+            if( !write( buffers[i].data, buffers[i].size ) )
+                return false;
+        }
+        return true;
+    #else
+        if( !is_open() )
+            return false;
+
+        // Gather up to a fixed number of buffers per call, skipping what was already written
+        const std::size_t max_count = 16;
+        std::size_t index  = 0;
+        std::size_t offset = 0;
+        while( index < count )
+        {
+            struct iovec vectors[max_count];
+            int n_vectors = 0;
+            for( std::size_t i = index; i < count && n_vectors < int(max_count); ++i )
+            {
+                std::size_t skip = i == index ? offset : 0;
+                if( buffers[i].size == skip )
+                    continue;
+                vectors[n_vectors].iov_base = const_cast<char *>( buffers[i].data + skip );
+                vectors[n_vectors].iov_len  = buffers[i].size - skip;
+                ++n_vectors;
+            }
+            if( n_vectors == 0 )
+                return true;
+
+            ssize_t written = ::writev( fd, vectors, n_vectors );
+            if( written < 0 && errno == EINTR )
+                continue;
+            if( written <= 0 )
+                return false;
+            file_position += static_cast<std::size_t>( written );
+
+            // Advance through the buffers by the number of bytes written
+            std::size_t remaining = static_cast<std::size_t>( written );
+            while( index < count && remaining >= buffers[index].size - offset )
+            {
+                remaining -= buffers[index].size - offset;
+                offset = 0;
+                ++index;
+            }
+            offset += remaining;
+        }
+        return true;
+    #endif
+    }
+}
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,390 @@
+#pragma once
+#ifndef LIBOVF_DETAIL_NUMBER_H
+#define LIBOVF_DETAIL_NUMBER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cfloat>
+#include <clocale>
+#include <string>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+    #include <emmintrin.h>
+    #define LIBOVF_USE_SSE2
+#endif
+
+namespace ovf
+{
+namespace detail
+{
+namespace number
+{
+    /*
+    Locale-independent parsing of decimal floating point numbers, working directly on a character range.
+
+    Numbers with at most 19 significant digits, which can be represented exactly as a double mantissa
+    and a power of ten, are converted with a single correctly rounded multiplication or division
+    (Clinger's fast path). This covers what is typically written into OVF files, e.g. "%22.12f".
+    Everything else is handed to strtod, after replacing the decimal point by the one of the current locale,
+    so the result is always the correctly rounded double.
+    */
+
+    // Powers of ten which are exactly representable as double
+    static const double exact_powers_of_ten[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    // Largest integer up to which all integers are exactly representable as double
+    static const uint64_t max_exact_mantissa = uint64_t(1) << 53;
+
+    // Parse with strtod on a local copy of the range, using the decimal point of the current locale
+    inline bool parse_double_fallback( const char * begin, const char * end, double & value )
+    {
+        const char decimal_point = std::localeconv()->decimal_point[0];
+        std::string buffer( begin, end );
+        for( auto & c : buffer )
+        {
+            if( c == '.' )
+                c = decimal_point;
+        }
+        char * parse_end = nullptr;
+        value = std::strtod( buffer.c_str(), &parse_end );
+        return parse_end == buffer.c_str() + buffer.size();
+    }
+
+    /*
+    Parse a number of the form [+-]digits[.digits][(e|E)[+-]digits] spanning exactly [begin, end).
+    Returns false if the range is not such a number.
+    */
+    inline bool parse_double( const char * begin, const char * end, double & value )
+    {
+        const char * pos = begin;
+
+        bool negative = false;
+        if( pos < end && ( *pos == '+' || *pos == '-' ) )
+            negative = *pos++ == '-';
+
+        uint64_t mantissa   = 0;
+        int n_significant   = 0;
+        int exponent        = 0;
+        bool any_digits     = false;
+
+        // Integer part
+        for( ; pos < end && *pos >= '0' && *pos <= '9'; ++pos )
+        {
+            any_digits = true;
+            if( mantissa == 0 && *pos == '0' )
+                continue;
+            if( n_significant < 19 )
+                mantissa = 10*mantissa + uint64_t( *pos - '0' );
+            else
+                ++exponent;
+            ++n_significant;
+        }
+
+        // Fractional part
+        if( pos < end && *pos == '.' )
+        {
+            ++pos;
+            for( ; pos < end && *pos >= '0' && *pos <= '9'; ++pos )
+            {
+                any_digits = true;
+                if( mantissa == 0 && *pos == '0' )
+                {
+                    --exponent;
+                    continue;
+                }
+                if( n_significant < 19 )
+                {
+                    mantissa = 10*mantissa + uint64_t( *pos - '0' );
+                    --exponent;
+                }
+                ++n_significant;
+            }
+        }
+
+        if( !any_digits )
+            return false;
+
+        // Exponent
+        if( pos < end && ( *pos == 'e' || *pos == 'E' ) )
+        {
+            ++pos;
+            bool negative_exponent = false;
+            if( pos < end && ( *pos == '+' || *pos == '-' ) )
+                negative_exponent = *pos++ == '-';
+            if( pos == end )
+                return false;
+            int explicit_exponent = 0;
+            for( ; pos < end && *pos >= '0' && *pos <= '9'; ++pos )
+            {
+                // Exponents this large are left to strtod
+                if( explicit_exponent > 100000 )
+                    return parse_double_fallback( begin, end, value );
+                explicit_exponent = 10*explicit_exponent + ( *pos - '0' );
+            }
+            exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+
+        if( pos != end )
+            return false;
+
+        if( mantissa == 0 )
+        {
+            value = negative ? -0.0 : 0.0;
+            return true;
+        }
+
+    #if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+        // Without strict double precision arithmetic (e.g. x87), the fast path would round twice
+        return parse_double_fallback( begin, end, value );
+    #else
+        // Digits beyond the 19th were dropped, so the mantissa is not exact
+        if( n_significant > 19 )
+            return parse_double_fallback( begin, end, value );
+
+        // Trailing zeros, e.g. from fixed precision output, only shift the exponent
+        while( mantissa % 10 == 0 )
+        {
+            mantissa /= 10;
+            ++exponent;
+        }
+
+        // Move excess powers of ten into the mantissa, as long as it stays exact
+        while( exponent > 22 && mantissa <= max_exact_mantissa / 10 )
+        {
+            mantissa *= 10;
+            --exponent;
+        }
+
+        if( mantissa > max_exact_mantissa || exponent < -22 || exponent > 22 )
+            return parse_double_fallback( begin, end, value );
+
+        double result = static_cast<double>( mantissa );
+        if( exponent < 0 )
+            result /= exact_powers_of_ten[-exponent];
+        else
+            result *= exact_powers_of_ten[exponent];
+        value = negative ? -result : result;
+        return true;
+    #endif
+    }
+
+    /*
+    Return the end of the longest number of the form [+-]digits[.digits][(e|E)[+-]digits] starting at pos,
+    or pos if there is none. An exponent marker which is not followed by digits is not part of the number.
+    */
+    inline const char * scan_number( const char * pos, const char * end )
+    {
+        const char * start = pos;
+        if( pos < end && ( *pos == '+' || *pos == '-' ) )
+            ++pos;
+
+        const char * digits_begin = pos;
+        while( pos < end && *pos >= '0' && *pos <= '9' )
+            ++pos;
+        bool any_digits = pos > digits_begin;
+        if( pos < end && *pos == '.' )
+        {
+            const char * fraction_begin = ++pos;
+            while( pos < end && *pos >= '0' && *pos <= '9' )
+                ++pos;
+            any_digits = any_digits || pos > fraction_begin;
+        }
+        if( !any_digits )
+            return start;
+
+        if( pos < end && ( *pos == 'e' || *pos == 'E' ) )
+        {
+            const char * exponent = pos + 1;
+            if( exponent < end && ( *exponent == '+' || *exponent == '-' ) )
+                ++exponent;
+            const char * exponent_digits = exponent;
+            while( exponent < end && *exponent >= '0' && *exponent <= '9' )
+                ++exponent;
+            if( exponent > exponent_digits )
+                pos = exponent;
+        }
+        return pos;
+    }
+
+    // Skip spaces and tabs. Text data is usually padded to a fixed width, so long runs are skipped 16 bytes at a time
+    inline const char * skip_blanks( const char * pos, const char * end )
+    {
+    #ifdef LIBOVF_USE_SSE2
+        const __m128i spaces = _mm_set1_epi8( ' ' );
+        const __m128i tabs   = _mm_set1_epi8( '\t' );
+        while( end - pos >= 16 )
+        {
+            __m128i chunk  = _mm_loadu_si128( reinterpret_cast<const __m128i *>( pos ) );
+            __m128i blanks = _mm_or_si128( _mm_cmpeq_epi8( chunk, spaces ), _mm_cmpeq_epi8( chunk, tabs ) );
+            unsigned int mask = ~static_cast<unsigned int>( _mm_movemask_epi8( blanks ) ) & 0xFFFFu;
+            if( mask != 0 )
+            {
+                // Position of the first byte which is not a blank
+                int offset = 0;
+                while( !( mask & 1u ) )
+                {
+                    mask >>= 1;
+                    ++offset;
+                }
+                return pos + offset;
+            }
+            pos += 16;
+        }
+    #endif
+        while( pos < end && ( *pos == ' ' || *pos == '\t' ) )
+            ++pos;
+        return pos;
+    }
+
+    /*
+    Formatting of values as fixed-point text with 12 decimals, right-aligned to a width of 22,
+    i.e. exactly what fmt "{:22.12f}" and printf "%22.12f" produce, but without parsing a format
+    specification or allocating for every value.
+
+    The value, m*2^e, is scaled by 10^12 and rounded (half to even) exactly in 128-bit integer
+    arithmetic, so this is only available where the compiler provides __int128 and only for
+    values below 2^87. Everything else is left to the caller.
+    */
+    static const char digit_pairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    // The width of the fixed-point fields
+    static const int fixed_width = 22;
+    // Maximum number of characters written by format_fixed_12
+    static const std::size_t fixed_max_size = 64;
+
+    // Write the digits of value so that they end right before out_end, returning where they begin
+    inline char * write_digits_backwards( uint64_t value, char * out_end )
+    {
+        while( value >= 100 )
+        {
+            std::size_t pair = std::size_t( value % 100 ) * 2;
+            value /= 100;
+            out_end -= 2;
+            std::memcpy( out_end, digit_pairs + pair, 2 );
+        }
+        if( value >= 10 )
+        {
+            out_end -= 2;
+            std::memcpy( out_end, digit_pairs + value * 2, 2 );
+        }
+        else
+            *--out_end = char( '0' + value );
+        return out_end;
+    }
+
+    /*
+    Format value like "%22.12f" into out, which needs room for fixed_max_size characters.
+    Returns the number of characters written, or 0 if the value needs to be formatted otherwise.
+    */
+    inline std::size_t format_fixed_12( double value, char * out )
+    {
+    #if defined(__SIZEOF_INT128__)
+        if( !std::isfinite( value ) )
+            return 0;
+
+        uint64_t bits;
+        std::memcpy( &bits, &value, sizeof(double) );
+        const bool negative = ( bits >> 63 ) != 0;
+        const int biased_exponent = int( ( bits >> 52 ) & 0x7FF );
+        uint64_t mantissa = bits & ( ( uint64_t(1) << 52 ) - 1 );
+        int exponent;
+        if( biased_exponent == 0 )
+            exponent = -1074;
+        else
+        {
+            mantissa |= uint64_t(1) << 52;
+            exponent = biased_exponent - 1075;
+        }
+
+        // mantissa * 10^12 < 2^93, which leaves room for shifting up to 2^34
+        if( exponent > 34 )
+            return 0;
+
+        typedef unsigned __int128 uint128;
+        const uint64_t scale = 1000000000000ULL;
+        const uint128 scaled = uint128( mantissa ) * scale;
+        uint128 rounded;
+        if( exponent >= 0 )
+            rounded = scaled << exponent;
+        else if( exponent <= -127 )
+            rounded = 0;
+        else
+        {
+            const int shift = -exponent;
+            rounded = scaled >> shift;
+            const uint128 remainder = scaled - ( rounded << shift );
+            const uint128 half = uint128(1) << ( shift - 1 );
+            if( remainder > half || ( remainder == half && ( rounded & 1 ) ) )
+                ++rounded;
+        }
+
+        // Assemble the text backwards from the end of a local buffer
+        char buffer[fixed_max_size];
+        char * end = buffer + fixed_max_size;
+        char * pos = end;
+
+        uint64_t integer_part;
+        uint64_t fraction;
+        uint128 integer_high = 0;
+        if( rounded < ( uint128(1) << 64 ) )
+        {
+            const uint64_t small = uint64_t( rounded );
+            integer_part = small / scale;
+            fraction     = small % scale;
+        }
+        else
+        {
+            const uint128 integer = rounded / scale;
+            fraction     = uint64_t( rounded % scale );
+            const uint64_t chunk = 10000000000000000000ULL;
+            integer_high = integer / chunk;
+            integer_part = uint64_t( integer % chunk );
+        }
+
+        // Exactly 12 decimals
+        for( int i = 0; i < 6; ++i )
+        {
+            pos -= 2;
+            std::memcpy( pos, digit_pairs + ( fraction % 100 ) * 2, 2 );
+            fraction /= 100;
+        }
+        *--pos = '.';
+
+        if( integer_high > 0 )
+        {
+            // The lower 19 digits including leading zeros, then the rest
+            char * chunk_begin = write_digits_backwards( integer_part, pos );
+            while( pos - chunk_begin < 19 )
+                *--chunk_begin = '0';
+            pos = write_digits_backwards( uint64_t( integer_high ), chunk_begin );
+        }
+        else
+            pos = write_digits_backwards( integer_part, pos );
+
+        if( negative )
+            *--pos = '-';
+
+        std::size_t length = std::size_t( end - pos );
+        std::size_t padding = length < std::size_t( fixed_width ) ? fixed_width - length : 0;
+        std::memset( out, ' ', padding );
+        std::memcpy( out + padding, pos, length );
+        return padding + length;
+    #else
+        return 0;
+    #endif
+    }
+}
+}
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "ovf.h"
 #include <detail/parse_rules.hpp>
+#include <detail/index.hpp>
 
 #include <fmt/format.h>
 #include <fmt/ostream.h>
@@ -12,7 +13,9 @@
 #include <vector>
 #include <array>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 
 namespace ovf
 {
@@ -59,21 +62,153 @@ namespace parse
     }
 
     /*
-    Read the overall file header and locate and count segments in the file
-    (the segments are stored in memory!)
+    Map the file again, e.g. after it has grown. If data views into the current mapping are
+    still held, it is kept alive until they are released instead of being unmapped.
+    */
+    inline bool remap(ovf_file & file)
+    {
+        auto & state = *file._state;
+        if( !state.data_views.empty() && state.mapping.is_open() )
+        {
+            state.retired_mappings.emplace_back( new io::file_mapping() );
+            state.retired_mappings.back()->swap( state.mapping );
+        }
+        return state.mapping.open(file.file_name);
+    }
+
+    inline void save_index(ovf_file & file);
+
+    /*
+    Index the next segment after the ones located so far, starting at the scan position.
+    Returns false when there are no more segments, in which case the scan is complete.
+    */
+    inline bool scan_next_segment(ovf_file & file)
+    {
+        auto & state = *file._state;
+        if( state.scan_complete )
+            return false;
+
+        for( int attempt = 0; attempt < 2; ++attempt )
+        {
+            try
+            {
+                if( state.mapping.is_open() && state.scan_position < state.mapping.size() )
+                {
+                    pegtl::memory_input<> in( state.mapping.data() + state.scan_position,
+                        state.mapping.size() - state.scan_position, file.file_name );
+                    state.index_entry = segment_index_entry();
+                    state.index_meshtype = "";
+                    if( pegtl::parse< v2::index_segment, v2::ovf_segment_index_action >( in, file ) )
+                    {
+                        state.scan_position = state.segment_index.back().end;
+                        return true;
+                    }
+                }
+            }
+            catch( ... )
+            {
+            }
+
+            // The file may have grown since it was mapped, e.g. by appending through this handle
+            std::size_t size = 0;
+            if( attempt > 0 || !io::file_size(file.file_name, size) || size <= state.mapping.size() ||
+                !remap(file) )
+                break;
+        }
+
+        state.scan_complete = true;
+
+        /*
+        Anything but blanks after the last complete segment is what an interrupted append left behind,
+        e.g. a segment whose count was already updated or not yet. It is cut off by the next append.
+        */
+        if( state.mapping.is_open() && state.scan_position < state.mapping.size() )
+        {
+            const char * pos = state.mapping.data() + state.scan_position;
+            const char * end = state.mapping.data() + state.mapping.size();
+            while( pos < end && ( *pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n' ) )
+                ++pos;
+            if( pos < end )
+                state.recovered_end = state.scan_position;
+        }
+
+        // Store the index so the next open does not need to scan the file again
+        if( ( state.open_flags & OVF_OPEN_SIDECAR_INDEX ) && int(state.segment_index.size()) == file.n_segments )
+            save_index(file);
+
+        return false;
+    }
+
+    /*
+    Make sure the given segment is located and the mapping covers it.
+    With lazy opening, the file is scanned forward up to the requested segment.
+    The file may also have grown since it was mapped, e.g. when segments were appended through the same handle.
+    */
+    inline bool map_segment(ovf_file & file, int index)
+    {
+        while( int(file._state->segment_index.size()) <= index && scan_next_segment(file) )
+        {
+        }
+        if( index >= int(file._state->segment_index.size()) )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf: segment {} could not be located, file \'{}\' contains only {} segments",
+                index, file.file_name, file._state->segment_index.size());
+            return false;
+        }
+
+        const segment_index_entry & entry = file._state->segment_index[index];
+        auto & mapping = file._state->mapping;
+        if( mapping.is_open() && mapping.size() >= entry.end )
+            return true;
+        if( remap(file) && mapping.size() >= entry.end )
+            return true;
+        file._state->message_latest = fmt::format(
+            "libovf: could not map segment {} of file \'{}\'", index, file.file_name);
+        return false;
+    }
+
+    /*
+    Read the overall file header and build the index of the segments in the file
+    in a single pass over the memory-mapped file.
+    When the file is opened lazily, only the file header is parsed and segments are located on demand.
     */
     inline int initial(ovf_file & file)
     try
     {
-        pegtl::file_input<> in( file.file_name );
+        file._state->segment_index.clear();
+        file._state->scan_position = 0;
+        file._state->scan_complete = true;
+        if( !remap(file) )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf initial: could not map file \'{}\'", file.file_name);
+            return OVF_ERROR;
+        }
+        pegtl::memory_input<> in( file._state->mapping.data(), file._state->mapping.size(), file.file_name );
         bool success = pegtl::parse< ovf_file_header, ovf_file_action >( in, file );
         if( success )
         {
             success = false;
+            bool lazy = file._state->open_flags & OVF_OPEN_LAZY;
             if( file.version == 2 )
             {
-                success = pegtl::parse< pegtl::until<pegtl::until<pegtl::at< pegtl::seq<v2::begin, TAO_PEGTL_ISTRING("Segment"), pegtl::eol >>>> >( in, file );
-                success = pegtl::parse< pegtl::plus<v2::segment>, v2::ovf_segment_action >( in, file );
+                if( ( file._state->open_flags & OVF_OPEN_SIDECAR_INDEX ) && index::load(file) )
+                    lazy = false;
+                else
+                {
+                    pegtl::parse< pegtl::until<pegtl::until<pegtl::at< pegtl::seq<v2::begin, TAO_PEGTL_ISTRING("Segment"), pegtl::eol >>>> >( in, file );
+                    file._state->scan_position = in.current() - file._state->mapping.data();
+                    file._state->scan_complete = false;
+                    if( !lazy )
+                    {
+                        while( scan_next_segment(file) )
+                        {
+                        }
+                    }
+                }
+                success = lazy || file._state->segment_index.size() > 0 ||
+                    ( file._state->open_flags & OVF_OPEN_RECOVER );
             }
             else if( file.version == 1 )
             {
@@ -92,14 +227,34 @@ namespace parse
 
             if( success )
             {
-                int n_located = file._state->file_contents.size();
-                if( file.n_segments != n_located )
+                int n_located = file._state->segment_index.size();
+                if( !lazy && file.n_segments != n_located )
                 {
+                    /*
+                    An append which was interrupted after writing the segment but before updating the count
+                    leaves more complete segments than counted, which are used. Fewer complete segments than
+                    counted are only accepted when recovering, as data may have been lost.
+                    */
+                    if( n_located < file.n_segments && !( file._state->open_flags & OVF_OPEN_RECOVER ) )
+                    {
+                        file._state->message_latest = fmt::format(
+                            "libovf initial: n_segments specified in header ({}) is different from the number"
+                            " of segments ({}) found in the file \'{}\'...",
+                            file.n_segments, n_located, file.file_name);
+                        return OVF_INVALID;
+                    }
+
                     file._state->message_latest = fmt::format(
                         "libovf initial: n_segments specified in header ({}) is different from the number"
-                        " of segments ({}) found in the file \'{}\'...",
+                        " of complete segments ({}) found in the file \'{}\', using the segments found",
                         file.n_segments, n_located, file.file_name);
-                    return OVF_INVALID;
+                    file.n_segments = n_located;
+                }
+                else if( file._state->recovered_end > 0 )
+                {
+                    file._state->message_latest = fmt::format(
+                        "libovf initial: file \'{}\' ends with an incomplete segment after {} complete segments,"
+                        " which is cut off by the next append", file.file_name, n_located);
                 }
 
                 file.is_ovf = true;
@@ -135,12 +290,89 @@ namespace parse
         return OVF_ERROR;
     }
 
-    // Reads in the header info into a given segment
-    inline int segment_header(ovf_file & file, int index, ovf_segment & segment)
+    // Keep the fields which parsing a header has set in the given segment
+    inline std::shared_ptr<const segment_header_fields> keep_header_fields(const ovf_file & file, const ovf_segment & segment)
+    {
+        std::shared_ptr<segment_header_fields> fields( new segment_header_fields() );
+        fields->title          = segment.title;
+        fields->found_comment  = file._state->found_comment;
+        if( fields->found_comment )
+            fields->comment    = segment.comment;
+        fields->valueunits     = segment.valueunits;
+        fields->valuelabels    = segment.valuelabels;
+        fields->meshtype       = segment.meshtype;
+        fields->meshunit       = segment.meshunit;
+        fields->found_valuedim = file._state->found_valuedim;
+        fields->valuedim       = segment.valuedim;
+        fields->pointcount     = segment.pointcount;
+        fields->N              = segment.N;
+        for( int dim = 0; dim < 3; ++dim )
+        {
+            fields->n_cells[dim]    = segment.n_cells[dim];
+            fields->bounds_min[dim] = segment.bounds_min[dim];
+            fields->bounds_max[dim] = segment.bounds_max[dim];
+            fields->origin[dim]     = segment.origin[dim];
+            fields->step_size[dim]  = segment.step_size[dim];
+        }
+        return fields;
+    }
+
+    // Set the fields of a kept header in the given segment, as parsing the header would
+    inline int apply_header_fields(ovf_file & file, const segment_header_fields & fields, ovf_segment & segment)
+    {
+        if( segment.meshtype && std::string(segment.meshtype) != "" && std::string(segment.meshtype) != fields.meshtype )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf segment_header: meshtype \"{}\" was specified, but \"{}\" was expected!",
+                fields.meshtype, segment.meshtype);
+            return OVF_ERROR;
+        }
+
+        segment.title = strdup(fields.title.c_str());
+        if( fields.found_comment )
+            segment.comment = strdup(fields.comment.c_str());
+        segment.valueunits  = strdup(fields.valueunits.c_str());
+        segment.valuelabels = strdup(fields.valuelabels.c_str());
+        segment.meshtype    = strdup(fields.meshtype.c_str());
+        segment.meshunit    = strdup(fields.meshunit.c_str());
+        if( fields.found_valuedim )
+            segment.valuedim = fields.valuedim;
+        for( int dim = 0; dim < 3; ++dim )
+        {
+            segment.bounds_min[dim] = fields.bounds_min[dim];
+            segment.bounds_max[dim] = fields.bounds_max[dim];
+        }
+        if( fields.meshtype == "rectangular" )
+        {
+            for( int dim = 0; dim < 3; ++dim )
+            {
+                segment.n_cells[dim]   = fields.n_cells[dim];
+                segment.origin[dim]    = fields.origin[dim];
+                segment.step_size[dim] = fields.step_size[dim];
+            }
+        }
+        else
+            segment.pointcount = fields.pointcount;
+        segment.N = fields.N;
+        return OVF_OK;
+    }
+
+    // Reads in the header info into a given segment. If it cannot be parsed, it is printed unless quiet is set
+    inline int segment_header(ovf_file & file, int index, ovf_segment & segment, bool quiet = false)
     try
     {
-        pegtl::memory_input<> in( file._state->file_contents[index], "" );
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        // Headers which were parsed before, or loaded from the sidecar index, are not parsed again
+        if( file._state->segment_index[index].header )
+            return apply_header_fields(file, *file._state->segment_index[index].header, segment);
+
+        // Only the header block is parsed, the index tells us where it is
+        const segment_index_entry & entry = file._state->segment_index[index];
+        pegtl::memory_input<> in( file._state->mapping.data() + entry.header_begin,
+            entry.header_end - entry.header_begin, "" );
         file._state->found_title        = false;
+        file._state->found_comment      = false;
         file._state->found_meshunit     = false;
         file._state->found_valuedim     = false;
         file._state->found_valueunits   = false;
@@ -166,7 +398,7 @@ namespace parse
 
         if( file.version == 2 )
         {
-            success = pegtl::parse< pegtl::plus<v2::segment_header>, v2::ovf_segment_header_action, v2::ovf_segment_header_control >( in, file, segment );
+            success = pegtl::parse< v2::header, v2::ovf_segment_header_action, v2::ovf_segment_header_control >( in, file, segment );
         }
         else if( file.version == 1 )
         {
@@ -185,17 +417,24 @@ namespace parse
         }
 
         if( success )
+        {
+            file._state->segment_index[index].header = keep_header_fields(file, segment);
             return OVF_OK;
+        }
         else
         {
             file._state->message_latest = "libovf segment_header: no success in parsing";
-            std::cerr << file._state->file_contents[index] << std::endl;
+            if( !quiet )
+                std::cerr << std::string( file._state->mapping.data() + entry.header_begin,
+                entry.header_end - entry.header_begin ) << std::endl;
             return OVF_INVALID;
         }
     }
     catch( v2::keyword_value_line_error & err )
     {
-        pegtl::memory_input<> in( file._state->file_contents[index], "" );
+        const segment_index_entry & entry = file._state->segment_index[index];
+        pegtl::memory_input<> in( file._state->mapping.data() + entry.header_begin,
+            entry.header_end - entry.header_begin, "" );
         const auto p = err.positions.front();
         std::string line = in.line_at(p);
         file._state->message_latest = fmt::format(
@@ -221,19 +460,61 @@ namespace parse
         return OVF_ERROR;
     }
 
+    /*
+    Save the sidecar index of a file, including the fields of all segment headers.
+    Headers which were not read yet are parsed for this, each of them only once.
+    */
+    inline void save_index(ovf_file & file)
+    {
+        static char empty[] = "";
+        for( int index = 0; index < int(file._state->segment_index.size()); ++index )
+        {
+            if( file._state->segment_index[index].header )
+                continue;
+            ovf_segment segment = ovf_segment();
+            segment.title = segment.comment = segment.valueunits = segment.valuelabels = empty;
+            segment.meshtype = segment.meshunit = empty;
+            // A header which cannot be parsed is not stored, reading it reports the error
+            std::string message = file._state->message_latest;
+            segment_header(file, index, segment, true);
+            file._state->message_latest = message;
+            for( char * string : { segment.title, segment.comment, segment.valueunits, segment.valuelabels,
+                                   segment.meshtype, segment.meshunit } )
+            {
+                if( string != empty )
+                    std::free( string );
+            }
+        }
+        index::save(file);
+    }
+
+    template<typename scalar>
+    int segment_data_range(ovf_file & file, int index, const ovf_segment & segment, long long first, long long count, scalar * data);
+
     // Reads the data of a segment into a given data array (float)
     template<typename scalar>
     int segment_data(ovf_file & file, int index, const ovf_segment & segment, scalar * data)
     try
     {
-        pegtl::memory_input<> in( file._state->file_contents[index], "" );
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        // Seek straight to the data block, the header is not parsed again
+        const segment_index_entry & entry = file._state->segment_index[index];
+
+        // A partial read only reads the requested cells and stops there instead of going through the whole block
+        if( segment.N > 0 && segment.N < entry.N && segment.valuedim == entry.valuedim )
+            return segment_data_range(file, index, segment, 0, segment.N, data);
+
+        pegtl::memory_input<> in( file._state->mapping.data() + entry.data_begin,
+            entry.data_end - entry.data_begin, "" );
         int retcode = OVF_ERROR;
         bool success = false;
 
         if( file.version == 2 )
         {
             file._state->max_data_index = segment.N*segment.valuedim;
-            success = pegtl::parse< v2::segment_data, v2::ovf_segment_data_action >( in, file, segment, data );
+            file._state->binary_values  = segment.N > 0 && segment.valuedim > 0 ? std::size_t(segment.N)*segment.valuedim : 0;
+            success = pegtl::parse< v2::data_block, v2::ovf_segment_data_action >( in, file, segment, data );
             file._state->current_line = 0;
             file._state->current_column = 0;
         }
@@ -289,6 +570,509 @@ namespace parse
             return OVF_ERROR;
         }
     }
+
+    /*
+    Locate a segment and make sure that its data block is binary, has the size given by the header
+    and starts with the correct check value. Returns OVF_INVALID otherwise.
+    */
+    inline int binary_data_block(ovf_file & file, int index, const char * caller)
+    {
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        const segment_index_entry & entry = file._state->segment_index[index];
+
+        if( entry.format != OVF_FORMAT_BIN4 && entry.format != OVF_FORMAT_BIN8 )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf {}: segment {} of file \'{}\' is not stored in binary", caller, index, file.file_name);
+            return OVF_INVALID;
+        }
+
+        std::size_t value_size = entry.format == OVF_FORMAT_BIN4 ? 4 : 8;
+        std::size_t n_values   = std::size_t(entry.N) * entry.valuedim;
+        if( entry.N <= 0 || entry.valuedim <= 0 || entry.payload_begin < entry.data_begin + value_size ||
+            entry.data_end - entry.payload_begin < n_values*value_size )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf {}: the data block of segment {} of file \'{}\' does not match its header",
+                caller, index, file.file_name);
+            return OVF_INVALID;
+        }
+
+        // The check value right before the values
+        const uint8_t * check = reinterpret_cast<const uint8_t *>( file._state->mapping.data() + entry.payload_begin - value_size );
+        bool check_ok = value_size == 4 ? endian::from_little_32( check ) == check::val_4b
+                                        : endian::from_little_64( check ) == check::val_8b;
+        if( !check_ok )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf {}: the check value of segment {} of file \'{}\' is wrong",
+                caller, index, file.file_name);
+            return OVF_INVALID;
+        }
+        return OVF_OK;
+    }
+
+    /*
+    Point directly into the mapped file at the values of a binary segment.
+    This is only possible if the values are stored in the byte order of the host.
+    Returns OVF_INVALID if the data cannot be viewed, in which case it needs to be read (and converted).
+    */
+    inline int segment_data_view(ovf_file & file, int index, const void *& data, int & count, int & format)
+    {
+        int retcode = binary_data_block(file, index, "segment_data_view");
+        if( retcode != OVF_OK )
+            return retcode;
+        if( !endian::is_little() )
+        {
+            file._state->message_latest = "libovf segment_data_view: binary data is little endian, but the host is not";
+            return OVF_INVALID;
+        }
+
+        const segment_index_entry & entry = file._state->segment_index[index];
+        std::size_t n_values = std::size_t(entry.N) * entry.valuedim;
+        if( n_values > std::size_t(std::numeric_limits<int>::max()) )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf segment_data_view: segment {} has {} values, which is more than a view can hold",
+                index, n_values);
+            return OVF_ERROR;
+        }
+        data   = file._state->mapping.data() + entry.payload_begin;
+        count  = int(n_values);
+        format = entry.format;
+        file._state->data_views.insert( data );
+        return OVF_OK;
+    }
+
+    // Selection of the components (columns) of a segment: bit i selects component i
+    static const unsigned long long all_components = ~0ull;
+
+    inline bool component_selected(unsigned long long components, int col)
+    {
+        return components == all_components || ( col < 64 && ( components >> col ) & 1 );
+    }
+
+    /*
+    Parse one line of Text or CSV data with n_cols values and store the selected ones into out.
+    Returns the beginning of the next line, or nullptr if the line does not hold n_cols values.
+    */
+    template<bool CSV, typename scalar>
+    const char * data_line(const char * pos, const char * end, scalar * out, int n_cols, unsigned long long components)
+    {
+        for( int col = 0; col < n_cols; ++col )
+        {
+            pos = number::skip_blanks( pos, end );
+            if( CSV && col > 0 && pos < end && *pos == ',' )
+                pos = number::skip_blanks( pos + 1, end );
+            const char * number_end = number::scan_number( pos, end );
+            if( number_end == pos )
+                return nullptr;
+            // Values which are not selected are only skipped
+            if( component_selected( components, col ) )
+            {
+                double value = 0;
+                if( !number::parse_double( pos, number_end, value ) )
+                    return nullptr;
+                *out++ = value;
+            }
+            pos = number_end;
+        }
+        pos = number::skip_blanks( pos, end );
+        if( CSV && pos < end && *pos == ',' )
+            pos = number::skip_blanks( pos + 1, end );
+        if( pos < end && *pos == '\r' )
+            ++pos;
+        if( pos >= end || *pos != '\n' )
+            return nullptr;
+        return pos + 1;
+    }
+
+    /*
+    Read the selected components of selected cells of a segment into data, one cell after the other.
+    The cells are given as runs of consecutive cells in increasing order: for_each_run( visit ) has to call
+    visit( first_cell, n_cells ) for each run and stop if it returns false.
+    Binary data is copied straight from the runs, or gathered with a stride if not all components are selected.
+    Text data is scanned line by line, where the lines before a run are only skipped and not parsed.
+    */
+    template<typename scalar, typename For_Each_Run>
+    int segment_data_runs(ovf_file & file, int index, For_Each_Run for_each_run, unsigned long long components,
+        scalar * data, const char * caller)
+    {
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        const segment_index_entry & entry = file._state->segment_index[index];
+        const std::size_t n_cols  = entry.valuedim;
+        const std::size_t n_cells = entry.N > 0 ? entry.N : 0;
+        const char * mapping = file._state->mapping.data();
+        bool success = true;
+
+        std::vector<std::size_t> selected;
+        for( std::size_t col = 0; col < n_cols; ++col )
+        {
+            if( component_selected( components, int(col) ) )
+                selected.push_back( col );
+        }
+        const std::size_t n_selected = selected.size();
+        const bool all_selected = n_selected == n_cols;
+
+        if( entry.format == OVF_FORMAT_BIN4 || entry.format == OVF_FORMAT_BIN8 )
+        {
+            int retcode = binary_data_block(file, index, caller);
+            if( retcode != OVF_OK )
+                return retcode;
+
+            const std::size_t value_size = entry.format == OVF_FORMAT_BIN4 ? 4 : 8;
+            const uint8_t * payload = reinterpret_cast<const uint8_t *>( mapping + entry.payload_begin );
+            for_each_run( [&]( std::size_t first, std::size_t count ) -> bool
+            {
+                if( first + count > n_cells )
+                    return success = false;
+                const uint8_t * values = payload + first*n_cols*value_size;
+                if( all_selected && value_size == 4 )
+                    endian::from_little_32_array( values, data, count*n_cols );
+                else if( all_selected )
+                    endian::from_little_64_array( values, data, count*n_cols );
+                else
+                {
+                    for( std::size_t i = 0; i < n_selected; ++i )
+                    {
+                        const uint8_t * column = values + selected[i]*value_size;
+                        if( value_size == 4 )
+                            endian::from_little_32_gather( column, n_cols*value_size, data + i, n_selected, count );
+                        else
+                            endian::from_little_64_gather( column, n_cols*value_size, data + i, n_selected, count );
+                    }
+                }
+                data += count*n_selected;
+                return true;
+            } );
+        }
+        else if( entry.format == OVF_FORMAT_TEXT || entry.format == OVF_FORMAT_CSV )
+        {
+            const bool csv = entry.format == OVF_FORMAT_CSV;
+            const char * pos = mapping + entry.payload_begin;
+            const char * end = mapping + entry.data_end;
+            std::size_t line = 0;
+            for_each_run( [&]( std::size_t first, std::size_t count ) -> bool
+            {
+                for( ; line < first && pos; ++line )
+                {
+                    pos = static_cast<const char *>( std::memchr( pos, '\n', end - pos ) );
+                    if( pos )
+                        ++pos;
+                }
+                for( std::size_t cell = 0; cell < count && pos; ++cell, ++line )
+                {
+                    pos = csv ? data_line<true>( pos, end, data, int(n_cols), components )
+                              : data_line<false>( pos, end, data, int(n_cols), components );
+                    data += n_selected;
+                }
+                return success = pos != nullptr;
+            } );
+        }
+        else
+        {
+            file._state->message_latest = fmt::format(
+                "libovf {}: segment {} of file \'{}\' has no data block", caller, index, file.file_name);
+            return OVF_INVALID;
+        }
+
+        if( !success )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf {}: the data block of segment {} of file \'{}\' does not match its header",
+                caller, index, file.file_name);
+            return OVF_INVALID;
+        }
+        return OVF_OK;
+    }
+
+    // Check that a segment holds data on the rectangular mesh of the given segment
+    inline bool matches_rectangular_mesh(ovf_file & file, int index, const ovf_segment & segment, const char * caller)
+    {
+        const segment_index_entry & entry = file._state->segment_index[index];
+        bool rectangular = entry.N > 0 && (long long)entry.n_cells[0] * entry.n_cells[1] * entry.n_cells[2] == entry.N;
+        if( !rectangular || segment.valuedim != entry.valuedim || segment.n_cells[0] != entry.n_cells[0] ||
+            segment.n_cells[1] != entry.n_cells[1] || segment.n_cells[2] != entry.n_cells[2] )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf {}: segment {} of file \'{}\' does not have the rectangular mesh of the given segment",
+                caller, index, file.file_name);
+            return false;
+        }
+        return true;
+    }
+
+    /*
+    Read the cells lo <= (x,y,z) < hi of a segment on a rectangular mesh, with x running fastest.
+    Only the rows of the region are read.
+    */
+    template<typename scalar>
+    int segment_data_region(ovf_file & file, int index, const ovf_segment & segment, const int lo[3], const int hi[3], scalar * data)
+    try
+    {
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        if( !matches_rectangular_mesh(file, index, segment, "segment_data_region") )
+            return OVF_INVALID;
+        const segment_index_entry entry = file._state->segment_index[index];
+        for( int dim = 0; dim < 3; ++dim )
+        {
+            if( lo[dim] < 0 || lo[dim] >= hi[dim] || hi[dim] > entry.n_cells[dim] )
+            {
+                file._state->message_latest = fmt::format(
+                    "libovf segment_data_region: invalid region [{}, {}) along axis {} for {} cells",
+                    lo[dim], hi[dim], dim, entry.n_cells[dim]);
+                return OVF_ERROR;
+            }
+        }
+
+        const std::size_t nx = entry.n_cells[0];
+        const std::size_t ny = entry.n_cells[1];
+        return segment_data_runs( file, index, [&]( const std::function<bool( std::size_t, std::size_t )> & visit )
+        {
+            for( std::size_t z = lo[2]; z < std::size_t(hi[2]); ++z )
+            {
+                for( std::size_t y = lo[1]; y < std::size_t(hi[1]); ++y )
+                {
+                    if( !visit( lo[0] + nx*( y + ny*z ), hi[0] - lo[0] ) )
+                        return;
+                }
+            }
+        }, all_components, data, "segment_data_region" );
+    }
+    catch( const std::exception & ex )
+    {
+        file._state->message_latest = fmt::format(
+            "libovf segment_data_region: std::exception \'{}\'", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        file._state->message_latest = "libovf segment_data_region: unknown exception";
+        return OVF_ERROR;
+    }
+
+    /*
+    Read every stride[dim]-th cell along each axis of a segment on a rectangular mesh, starting at the first cell.
+    Binary data is read only for the sampled cells, whole rows are read only if every cell of a row is sampled.
+    */
+    template<typename scalar>
+    int segment_data_strided(ovf_file & file, int index, const ovf_segment & segment, const int stride[3], scalar * data)
+    try
+    {
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        if( !matches_rectangular_mesh(file, index, segment, "segment_data_strided") )
+            return OVF_INVALID;
+        const segment_index_entry entry = file._state->segment_index[index];
+        for( int dim = 0; dim < 3; ++dim )
+        {
+            if( stride[dim] < 1 )
+            {
+                file._state->message_latest = fmt::format(
+                    "libovf segment_data_strided: invalid stride {} along axis {}", stride[dim], dim);
+                return OVF_ERROR;
+            }
+        }
+
+        const std::size_t nx = entry.n_cells[0];
+        const std::size_t ny = entry.n_cells[1];
+        const std::size_t nz = entry.n_cells[2];
+        const std::size_t sx = stride[0];
+        const std::size_t sy = stride[1];
+        const std::size_t sz = stride[2];
+        return segment_data_runs( file, index, [&]( const std::function<bool( std::size_t, std::size_t )> & visit )
+        {
+            for( std::size_t z = 0; z < nz; z += sz )
+            {
+                for( std::size_t y = 0; y < ny; y += sy )
+                {
+                    const std::size_t row = nx*( y + ny*z );
+                    if( sx == 1 )
+                    {
+                        if( !visit( row, nx ) )
+                            return;
+                        continue;
+                    }
+                    for( std::size_t x = 0; x < nx; x += sx )
+                    {
+                        if( !visit( row + x, 1 ) )
+                            return;
+                    }
+                }
+            }
+        }, all_components, data, "segment_data_strided" );
+    }
+    catch( const std::exception & ex )
+    {
+        file._state->message_latest = fmt::format(
+            "libovf segment_data_strided: std::exception \'{}\'", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        file._state->message_latest = "libovf segment_data_strided: unknown exception";
+        return OVF_ERROR;
+    }
+
+    /*
+    Read the cells first <= cell < first + count of a segment.
+    Binary data is read straight from the range, text data is parsed only up to the end of the range.
+    */
+    template<typename scalar>
+    int segment_data_range(ovf_file & file, int index, const ovf_segment & segment, long long first, long long count, scalar * data)
+    try
+    {
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        const segment_index_entry entry = file._state->segment_index[index];
+
+        if( segment.valuedim != entry.valuedim )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf segment_data_range: segment {} of file \'{}\' has valuedim {}, the given segment {}",
+                index, file.file_name, entry.valuedim, segment.valuedim);
+            return OVF_INVALID;
+        }
+        if( first < 0 || count <= 0 || first + count > entry.N )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf segment_data_range: invalid range of {} cells from cell {} for {} cells",
+                count, first, entry.N);
+            return OVF_ERROR;
+        }
+
+        return segment_data_runs( file, index, [&]( const std::function<bool( std::size_t, std::size_t )> & visit )
+        {
+            visit( first, count );
+        }, all_components, data, "segment_data_range" );
+    }
+    catch( const std::exception & ex )
+    {
+        file._state->message_latest = fmt::format(
+            "libovf segment_data_range: std::exception \'{}\'", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        file._state->message_latest = "libovf segment_data_range: unknown exception";
+        return OVF_ERROR;
+    }
+
+    /*
+    Read the data of the segments first <= index < first + count into one contiguous array, one segment after the other.
+    The shapes of all segments are checked against the given segment once, using the segment index,
+    so that the headers are not parsed again. The data blocks are then read in a single forward pass.
+    */
+    template<typename scalar>
+    int segments_data(ovf_file & file, int first, int count, const ovf_segment & segment, scalar * data)
+    try
+    {
+        if( !map_segment(file, first + count - 1) )
+            return OVF_ERROR;
+
+        for( int index = first; index < first + count; ++index )
+        {
+            const segment_index_entry & entry = file._state->segment_index[index];
+            if( entry.valuedim != segment.valuedim || entry.N != segment.N || entry.n_cells[0] != segment.n_cells[0] ||
+                entry.n_cells[1] != segment.n_cells[1] || entry.n_cells[2] != segment.n_cells[2] )
+            {
+                file._state->message_latest = fmt::format(
+                    "libovf segments_data: segment {} of file \'{}\' has valuedim {} and {}x{}x{} cells, "
+                    "the given segment valuedim {} and {}x{}x{} cells", index, file.file_name,
+                    entry.valuedim, entry.n_cells[0], entry.n_cells[1], entry.n_cells[2],
+                    segment.valuedim, segment.n_cells[0], segment.n_cells[1], segment.n_cells[2]);
+                return OVF_INVALID;
+            }
+        }
+
+        const std::size_t n_cells = segment.N;
+        const std::size_t n_values = n_cells*segment.valuedim;
+        for( int index = first; index < first + count; ++index )
+        {
+            int retcode = segment_data_runs( file, index, [&]( const std::function<bool( std::size_t, std::size_t )> & visit )
+            {
+                visit( 0, n_cells );
+            }, all_components, data, "segments_data" );
+            if( retcode != OVF_OK )
+                return retcode;
+            data += n_values;
+        }
+        return OVF_OK;
+    }
+    catch( const std::exception & ex )
+    {
+        file._state->message_latest = fmt::format(
+            "libovf segments_data: std::exception \'{}\'", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        file._state->message_latest = "libovf segments_data: unknown exception";
+        return OVF_ERROR;
+    }
+
+    /*
+    Read only the selected components of the first segment.N cells of a segment, packed one cell after the other.
+    */
+    template<typename scalar>
+    int segment_data_components(ovf_file & file, int index, const ovf_segment & segment, unsigned long long components, scalar * data)
+    try
+    {
+        if( !map_segment(file, index) )
+            return OVF_ERROR;
+        const segment_index_entry entry = file._state->segment_index[index];
+
+        if( segment.valuedim != entry.valuedim || segment.N <= 0 || segment.N > entry.N )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf segment_data_components: segment {} of file \'{}\' has valuedim {} and {} cells, "
+                "the given segment valuedim {} and N {}", index, file.file_name, entry.valuedim, entry.N,
+                segment.valuedim, segment.N);
+            return OVF_INVALID;
+        }
+        if( components == 0 || ( entry.valuedim < 64 && ( components >> entry.valuedim ) != 0 ) )
+        {
+            file._state->message_latest = fmt::format(
+                "libovf segment_data_components: invalid component mask {:#x} for valuedim {}", components, entry.valuedim);
+            return OVF_ERROR;
+        }
+
+        const std::size_t n_cells = segment.N;
+        return segment_data_runs( file, index, [&]( const std::function<bool( std::size_t, std::size_t )> & visit )
+        {
+            visit( 0, n_cells );
+        }, components, data, "segment_data_components" );
+    }
+    catch( const std::exception & ex )
+    {
+        file._state->message_latest = fmt::format(
+            "libovf segment_data_components: std::exception \'{}\'", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        file._state->message_latest = "libovf segment_data_components: unknown exception";
+        return OVF_ERROR;
+    }
+
+    // Release a view handed out by segment_data_view. Once none are held, retired mappings are unmapped
+    inline int segment_data_view_release(ovf_file & file, const void * data)
+    {
+        auto & views = file._state->data_views;
+        auto view = views.find( data );
+        if( view == views.end() )
+        {
+            file._state->message_latest = "libovf segment_data_view_release: the data is not a view which is held";
+            return OVF_ERROR;
+        }
+        views.erase( view );
+        if( views.empty() )
+            file._state->retired_mappings.clear();
+        return OVF_OK;
+    }
 }
 }
 }
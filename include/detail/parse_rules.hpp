@@ -4,16 +4,121 @@
 
 #include "ovf.h"
 #include <detail/helpers.hpp>
+#include <detail/io.hpp>
+#include <detail/number.hpp>
 
 #include <tao/pegtl.hpp>
 #include <fmt/format.h>
 
 #include <array>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <string>
+
+/*
+The fields of a segment header which a successful parse sets. They are kept, so that
+the header does not need to be parsed again, and stored in the sidecar index.
+The comment and valuedim are only set if they are given in the header,
+the mesh fields depend on the meshtype.
+*/
+struct segment_header_fields
+{
+    std::string title       = "";
+    std::string comment     = "";
+    std::string valueunits  = "";
+    std::string valuelabels = "";
+    std::string meshtype    = "";
+    std::string meshunit    = "";
+    bool found_comment  = false;
+    bool found_valuedim = false;
+    int valuedim   = 0;
+    int n_cells[3] = {0, 0, 0};
+    int pointcount = 0;
+    int N          = 0;
+    float bounds_min[3] = {0, 0, 0};
+    float bounds_max[3] = {0, 0, 0};
+    float origin[3]     = {0, 0, 0};
+    float step_size[3]  = {0, 0, 0};
+};
+
+/*
+Index entry of a segment, built when the file is opened.
+Byte offsets are relative to the beginning of the file and ranges are half-open.
+*/
+struct segment_index_entry
+{
+    // The whole segment, including leading empty lines
+    std::size_t begin         = 0;
+    std::size_t end           = 0;
+    // From "# Begin: Header" up to and including the "# End: Header" line
+    std::size_t header_begin  = 0;
+    std::size_t header_end    = 0;
+    // From "# Begin: Data" up to and including the "# End: Data" line
+    std::size_t data_begin    = 0;
+    std::size_t data_end      = 0;
+    // First byte of the data values (i.e. after the check value for binary data)
+    std::size_t payload_begin = 0;
+
+    // OVF_FORMAT_TEXT, OVF_FORMAT_CSV, OVF_FORMAT_BIN4 or OVF_FORMAT_BIN8; -1 if no data block was found
+    int format     = -1;
+    // Shape of the data as given in the segment header
+    int valuedim   = 0;
+    int n_cells[3] = {0, 0, 0};
+    int pointcount = 0;
+    int N          = 0;
+
+    // The parsed header, once it was read or loaded from the sidecar index
+    std::shared_ptr<const segment_header_fields> header{};
+};
 
 struct parser_state
 {
-    // For the segment strings
-    std::vector<std::string> file_contents{};
+    // Combination of OVF_OPEN_* flags the file was opened with
+    int open_flags = OVF_OPEN_DEFAULT;
+
+    // Number of threads used to format Text and CSV data when writing
+    int write_threads = 1;
+
+    // Read-only mapping of the file and the index of the segments within it
+    ovf::detail::io::file_mapping mapping{};
+    std::vector<segment_index_entry> segment_index{};
+
+    /*
+    Data views (pointers into the mapping) handed out and not yet released, the same segment may be viewed
+    more than once. While there are any, the file is not truncated and replaced mappings are kept in
+    retired_mappings instead of being unmapped.
+    */
+    std::multiset<const void *> data_views{};
+    std::vector<std::unique_ptr<ovf::detail::io::file_mapping>> retired_mappings{};
+
+    /*
+    Scanning for segments, which is done either entirely when the file is opened, or on demand
+    when it was opened lazily. scan_position is where the next segment is expected.
+    */
+    std::size_t scan_position = 0;
+    bool scan_complete = true;
+
+    /*
+    Descriptor for writing, kept open from the first write until the file is closed, so that
+    appending does not reopen the file. Writing assumes that no one else modifies the file meanwhile.
+    */
+    ovf::detail::io::file_writer writer{};
+
+    // Written segments are synced to the storage device every sync_interval segments (0: never)
+    int sync_interval = 0;
+    int n_unsynced = 0;
+
+    // End of the last complete segment of a file recovered after an interrupted append (0 if not recovered).
+    // Anything after it is incomplete and is cut off when appending
+    std::size_t recovered_end = 0;
+
+    // Segments were written since the sidecar index was saved, it is saved again when the file is closed
+    bool index_changed = false;
+
+    // For building the segment index
+    segment_index_entry index_entry{};
+    std::string index_meshtype="";
 
     // for reading data blocks
     int current_column = 0;
@@ -23,6 +128,7 @@ struct parser_state
 
     // Whether certain keywords were found in parsing
     bool found_title        = false;
+    bool found_comment      = false;
     bool found_meshunit     = false;
     bool found_valuedim     = false;
     bool found_valueunits   = false;
@@ -53,6 +159,8 @@ struct parser_state
     std::string message_out="", message_latest="";
 
     int max_data_index=0;
+    // Number of values in the binary data block being parsed, if known (0 otherwise)
+    std::size_t binary_values=0;
     int tmp_idx=0;
     std::array<double, 3> tmp_vec3 = std::array<double, 3>{0,0,0};
 
@@ -267,34 +375,150 @@ namespace parse
         {};
 
 
-        struct text_value_float
-            : pegtl::seq<
-                opt_plus_minus,
-                decimal_number >
-        {};
+        /*
+        The lines of a Text or CSV data block, each containing at least one value.
+        Instead of going through the grammar token by token, the lines are scanned by hand and
+        the values are stored straight into the data array (the states of the data grammar).
+        Values are separated by blanks, or for CSV by commas optionally padded with blanks,
+        and a CSV line may end with a comma.
+        The row and column are tracked as for the other data blocks: values beyond
+        parser_state::max_data_index are skipped. Scanning stops at the first line which is
+        not a data line, e.g. the end marker of the block.
+        */
+        template< bool CSV >
+        struct data_lines
+        {
+            using analyze_t = pegtl::analysis::generic< pegtl::analysis::rule_type::ANY >;
+
+            template< pegtl::apply_mode A,
+                      pegtl::rewind_mode M,
+                      template< typename... > class Action,
+                      template< typename... > class Control,
+                      typename Input,
+                      typename scalar >
+            static bool match( Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
+            {
+                const char * pos = in.current();
+                const char * end = in.end();
 
-        struct line_data_txt
-            : pegtl::plus< pegtl::pad< text_value_float, pegtl::blank > >
-        {};
-        struct line_data_csv
-            : pegtl::seq<
-                pegtl::list< pegtl::pad<text_value_float, pegtl::blank>, pegtl::one<','> >,
-                pegtl::opt< pegtl::pad< pegtl::one<','>, pegtl::blank > >
-                >
-        {};
+                const long long n_cols    = segment.valuedim;
+                const long long max_index = f._state->max_data_index;
+                long long row = f._state->current_line;
+                long long col = f._state->current_column;
+                bool any_lines = false;
+
+                while( pos < end )
+                {
+                    const char * line_begin = pos;
+                    bool line_complete = false;
+
+                    pos = number::skip_blanks( pos, end );
+                    const char * number_end = number::scan_number( pos, end );
+                    while( number_end != pos )
+                    {
+                        double value = 0;
+                        if( !number::parse_double( pos, number_end, value ) )
+                            break;
+
+                        long long idx = col + row*n_cols;
+                        if( idx < max_index )
+                        {
+                            data[idx] = value;
+                            ++col;
+                        }
+
+                        pos = number::skip_blanks( number_end, end );
+                        bool separated = !CSV;
+                        if( CSV && pos < end && *pos == ',' )
+                        {
+                            pos = number::skip_blanks( pos + 1, end );
+                            separated = true;
+                        }
+
+                        if( pos < end && *pos == '\n' )
+                        {
+                            ++pos;
+                            line_complete = true;
+                            break;
+                        }
+                        if( end - pos >= 2 && pos[0] == '\r' && pos[1] == '\n' )
+                        {
+                            pos += 2;
+                            line_complete = true;
+                            break;
+                        }
+
+                        if( !separated )
+                            break;
+                        number_end = number::scan_number( pos, end );
+                    }
+
+                    if( !line_complete )
+                    {
+                        pos = line_begin;
+                        break;
+                    }
+                    col = 0;
+                    ++row;
+                    any_lines = true;
+                }
+
+                f._state->current_line   = int( row );
+                f._state->current_column = int( col );
+                if( !any_lines )
+                    return false;
+
+                // Line numbers are only used for error messages, so they are not counted within data blocks
+                in.bump_in_this_line( pos - in.current() );
+                return true;
+            }
+        };
+
+        /*
+        The values of a binary data block. If the number of values is known from the header
+        (parser_state::binary_values), the payload length is computed and the end marker is only
+        checked at the expected position. Otherwise, or if the marker is not there, every byte
+        is tested for the end marker.
+        */
+        template< std::size_t Size, typename End_Marker >
+        struct bytes_bin
+        {
+            using analyze_t = pegtl::analysis::generic< pegtl::analysis::rule_type::OPT >;
+
+            template< pegtl::apply_mode A,
+                      pegtl::rewind_mode M,
+                      template< typename... > class Action,
+                      template< typename... > class Control,
+                      typename Input,
+                      typename... States >
+            static bool match( Input& in, ovf_file & f, States&&... st )
+            {
+                const std::size_t n_bytes = Size * f._state->binary_values;
+                if( n_bytes > 0 && in.size( n_bytes ) > n_bytes )
+                {
+                    auto m = in.template mark< pegtl::rewind_mode::REQUIRED >();
+                    // Binary data has no meaningful lines, so there is no need to count them
+                    in.bump_in_this_line( n_bytes );
+                    // The values are usually followed by a newline before the end marker
+                    if( pegtl::match< pegtl::seq< pegtl::opt<pegtl::eol>, pegtl::at<End_Marker> >, pegtl::apply_mode::NOTHING, pegtl::rewind_mode::ACTIVE, pegtl::nothing, pegtl::normal >( in, f, st... ) )
+                        return m( true );
+                }
+                return pegtl::match< pegtl::star< pegtl::not_at<End_Marker>, pegtl::any >, pegtl::apply_mode::NOTHING, pegtl::rewind_mode::ACTIVE, pegtl::nothing, pegtl::normal >( in, f, st... );
+            }
+        };
 
         struct check_value_bin_4
             : tao::pegtl::uint32_le::any
         {};
         struct bytes_bin_4
-            : pegtl::seq< pegtl::star< pegtl::not_at< pegtl::seq<end, TAO_PEGTL_ISTRING("Data Binary 4"), pegtl::eol> >, pegtl::any > >
+            : bytes_bin< 4, pegtl::seq<end, TAO_PEGTL_ISTRING("Data Binary 4"), pegtl::eol> >
         {};
 
         struct check_value_bin_8
             : tao::pegtl::uint64_le::any
         {};
         struct bytes_bin_8
-            : pegtl::seq< pegtl::star< pegtl::not_at< pegtl::seq<end, TAO_PEGTL_ISTRING("Data Binary 8"), pegtl::eol> >, pegtl::any > >
+            : bytes_bin< 8, pegtl::seq<end, TAO_PEGTL_ISTRING("Data Binary 8"), pegtl::eol> >
         {};
 
         //////////////////////////////////////////////
@@ -348,43 +572,264 @@ namespace parse
             >
         {};
 
-        //
-        struct segment
+        /*
+        Rules to build the segment index. These locate the header and data blocks of a segment
+        and pick up the keywords which determine the shape of the data. They do not validate
+        the header, which is done when it is actually read.
+        */
+
+        struct index_header_line
+            : pegtl::sor<
+                pegtl::seq< empty_line, pegtl::opt<comment>, pegtl::eol >,
+                pegtl::seq< comment, pegtl::eol >,
+                keyword_value_line,
+                pegtl::until< pegtl::eol > >
+        {};
+
+        struct index_header
+            : pegtl::seq<
+                begin, TAO_PEGTL_ISTRING("Header"), finish_line,
+                pegtl::until< pegtl::seq<end, TAO_PEGTL_ISTRING("Header")>, index_header_line >,
+                finish_line >
+        {};
+
+        struct index_begin_data_text
+            : pegtl::seq< begin, TAO_PEGTL_ISTRING("Data Text"), pegtl::eol >
+        {};
+
+        struct index_begin_data_csv
+            : pegtl::seq< begin, TAO_PEGTL_ISTRING("Data CSV"), pegtl::eol >
+        {};
+
+        struct index_begin_data_binary_4
+            : pegtl::seq< begin, TAO_PEGTL_ISTRING("Data Binary 4"), pegtl::eol >
+        {};
+
+        struct index_begin_data_binary_8
+            : pegtl::seq< begin, TAO_PEGTL_ISTRING("Data Binary 8"), pegtl::eol >
+        {};
+
+        /*
+        Like pegtl::until< Marker > for a marker starting with '#', which cannot appear in text data.
+        Instead of testing for the marker at every byte, the input is searched for the next '#' with memchr.
+        */
+        template< typename Marker >
+        struct until_marker
+        {
+            using analyze_t = pegtl::analysis::generic< pegtl::analysis::rule_type::SEQ, Marker >;
+
+            template< pegtl::apply_mode A,
+                      pegtl::rewind_mode M,
+                      template< typename... > class Action,
+                      template< typename... > class Control,
+                      typename Input,
+                      typename... States >
+            static bool match( Input& in, States&&... st )
+            {
+                auto m = in.template mark< M >();
+                while( true )
+                {
+                    const void * hash = std::memchr( in.current(), '#', in.end() - in.current() );
+                    if( !hash )
+                        return m( false );
+                    // Line numbers are only used for error messages, so they are not counted within data blocks
+                    in.bump_in_this_line( static_cast<const char *>( hash ) - in.current() );
+                    if( Control< Marker >::template match< A, pegtl::rewind_mode::REQUIRED, Action, Control >( in, st... ) )
+                        return m( true );
+                    in.bump_in_this_line( 1 );
+                }
+            }
+        };
+
+        struct index_data
+            : pegtl::sor<
+                pegtl::seq<
+                    index_begin_data_text,
+                    until_marker< pegtl::seq<end, TAO_PEGTL_ISTRING("Data Text"), pegtl::eol> > >,
+                pegtl::seq<
+                    index_begin_data_csv,
+                    until_marker< pegtl::seq<end, TAO_PEGTL_ISTRING("Data CSV"), pegtl::eol> > >,
+                pegtl::seq<
+                    index_begin_data_binary_4, check_value_bin_4, bytes_bin_4,
+                    pegtl::seq<end, TAO_PEGTL_ISTRING("Data Binary 4"), pegtl::eol> >,
+                pegtl::seq<
+                    index_begin_data_binary_8, check_value_bin_8, bytes_bin_8,
+                    pegtl::seq<end, TAO_PEGTL_ISTRING("Data Binary 8"), pegtl::eol> > >
+        {};
+
+        struct index_segment
             : pegtl::seq<
                 pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
                 pegtl::seq< begin, TAO_PEGTL_ISTRING("Segment"), pegtl::eol>,
-                pegtl::until<pegtl::seq<end, TAO_PEGTL_ISTRING("Segment")>>, pegtl::eol >
+                pegtl::until<
+                    pegtl::seq<end, TAO_PEGTL_ISTRING("Segment")>,
+                    pegtl::sor< index_header, index_data, pegtl::until<pegtl::eol> > >,
+                pegtl::eol >
         {};
 
         // Class template for user-defined actions that does nothing by default.
         template< typename Rule >
-        struct ovf_segment_action
+        struct ovf_segment_index_action
             : pegtl::nothing< Rule >
         {};
 
         template<>
-        struct ovf_segment_action< segment >
+        struct ovf_segment_index_action< keyword >
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                f._state->keyword = in.string();
+                std::transform(f._state->keyword.begin(), f._state->keyword.end(),f._state->keyword.begin(), ::tolower);
+            }
+        };
+
+        template<>
+        struct ovf_segment_index_action< value >
         {
             template< typename Input >
-            static void apply( const Input& in, ovf_file & file )
+            static void apply( const Input& in, ovf_file & f )
             {
-                file._state->file_contents.push_back(in.string());
+                f._state->value = in.string();
             }
         };
 
-        //////////////////////////////////////////////
+        template<>
+        struct ovf_segment_index_action< keyword_value_line >
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                auto & entry = f._state->index_entry;
+                const char * value = f._state->value.c_str();
 
-        //
-        struct segment_header
-            : pegtl::seq<
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                pegtl::seq< begin, TAO_PEGTL_ISTRING("Segment"), pegtl::eol>,
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                header,
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                pegtl::until<pegtl::seq<end, TAO_PEGTL_ISTRING("Segment")>>, pegtl::eol >
+                if( f._state->keyword == "valuedim" )
+                    entry.valuedim = std::strtol(value, nullptr, 10);
+                else if( f._state->keyword == "meshtype" )
+                {
+                    f._state->index_meshtype = f._state->value;
+                    std::transform(f._state->index_meshtype.begin(), f._state->index_meshtype.end(),
+                        f._state->index_meshtype.begin(), ::tolower);
+                }
+                else if( f._state->keyword == "xnodes" )
+                    entry.n_cells[0] = std::strtol(value, nullptr, 10);
+                else if( f._state->keyword == "ynodes" )
+                    entry.n_cells[1] = std::strtol(value, nullptr, 10);
+                else if( f._state->keyword == "znodes" )
+                    entry.n_cells[2] = std::strtol(value, nullptr, 10);
+                else if( f._state->keyword == "pointcount" )
+                    entry.pointcount = std::strtol(value, nullptr, 10);
+
+                f._state->keyword = "";
+                f._state->value = "";
+            }
+        };
+
+        template<>
+        struct ovf_segment_index_action< index_header >
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                f._state->index_entry.header_begin = in.begin() - f._state->mapping.data();
+                f._state->index_entry.header_end   = in.end()   - f._state->mapping.data();
+            }
+        };
+
+        template< int Format >
+        struct ovf_segment_index_begin_data_action
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                auto & entry = f._state->index_entry;
+                entry.format        = Format;
+                entry.data_begin    = in.begin() - f._state->mapping.data();
+                entry.payload_begin = in.end()   - f._state->mapping.data();
+
+                // The number of values expected in the data block, if the header contained everything needed
+                bool irregular = f._state->index_meshtype == "irregular" ||
+                    ( f._state->index_meshtype == "" && entry.pointcount > 0 );
+                long long n_points = irregular ? entry.pointcount :
+                    (long long)entry.n_cells[0] * entry.n_cells[1] * entry.n_cells[2];
+                if( n_points > 0 && entry.valuedim > 0 )
+                    f._state->binary_values = std::size_t( n_points ) * entry.valuedim;
+                else
+                    f._state->binary_values = 0;
+            }
+        };
+
+        template<>
+        struct ovf_segment_index_action< index_begin_data_text >
+            : ovf_segment_index_begin_data_action< OVF_FORMAT_TEXT >
+        {};
+
+        template<>
+        struct ovf_segment_index_action< index_begin_data_csv >
+            : ovf_segment_index_begin_data_action< OVF_FORMAT_CSV >
+        {};
+
+        template<>
+        struct ovf_segment_index_action< index_begin_data_binary_4 >
+            : ovf_segment_index_begin_data_action< OVF_FORMAT_BIN4 >
+        {};
+
+        template<>
+        struct ovf_segment_index_action< index_begin_data_binary_8 >
+            : ovf_segment_index_begin_data_action< OVF_FORMAT_BIN8 >
         {};
 
+        // The binary data values start after the check value
+        template<>
+        struct ovf_segment_index_action< check_value_bin_4 >
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                f._state->index_entry.payload_begin = in.end() - f._state->mapping.data();
+            }
+        };
+
+        template<>
+        struct ovf_segment_index_action< check_value_bin_8 >
+            : ovf_segment_index_action< check_value_bin_4 >
+        {};
+
+        template<>
+        struct ovf_segment_index_action< index_data >
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                f._state->index_entry.data_end = in.end() - f._state->mapping.data();
+            }
+        };
+
+        template<>
+        struct ovf_segment_index_action< index_segment >
+        {
+            template< typename Input >
+            static void apply( const Input& in, ovf_file & f )
+            {
+                auto & entry = f._state->index_entry;
+                entry.begin = in.begin() - f._state->mapping.data();
+                entry.end   = in.end()   - f._state->mapping.data();
+
+                bool irregular = f._state->index_meshtype == "irregular" ||
+                    ( f._state->index_meshtype == "" && entry.pointcount > 0 );
+                if( irregular )
+                    entry.N = entry.pointcount;
+                else
+                    entry.N = entry.n_cells[0] * entry.n_cells[1] * entry.n_cells[2];
+
+                f._state->segment_index.push_back(entry);
+                entry = segment_index_entry();
+                f._state->index_meshtype = "";
+            }
+        };
+
+        //////////////////////////////////////////////
+
         // Class template for user-defined actions that does nothing by default.
         template< typename Rule >
         struct ovf_segment_header_action
@@ -392,7 +837,7 @@ namespace parse
         {};
 
         template<>
-        struct ovf_segment_header_action< segment_header >
+        struct ovf_segment_header_action< header >
         {
             template< typename Input >
             static void apply( const Input& in, ovf_file & file, ovf_segment & segment )
@@ -510,7 +955,10 @@ namespace parse
                     f._state->found_title = true;
                 }
                 else if( f._state->keyword == "desc" )
+                {
                     segment.comment = strdup(f._state->value.c_str());
+                    f._state->found_comment = true;
+                }
                 else if( f._state->keyword == "meshunit" )
                 {
                     segment.meshunit = strdup(f._state->value.c_str());
@@ -687,7 +1135,7 @@ namespace parse
         struct data_text
             : pegtl::seq<
                 begin, TAO_PEGTL_ISTRING("Data Text"), pegtl::eol,
-                pegtl::plus< line_data_txt, pegtl::eol >,
+                data_lines< false >,
                 end, TAO_PEGTL_ISTRING("Data Text"), pegtl::eol
                 >
         {};
@@ -695,7 +1143,7 @@ namespace parse
         struct data_csv
             : pegtl::seq<
                 begin, TAO_PEGTL_ISTRING("Data CSV"), pegtl::eol,
-                pegtl::plus< line_data_csv, pegtl::eol >,
+                data_lines< true >,
                 end, TAO_PEGTL_ISTRING("Data CSV"), pegtl::eol
                 >
         {};
@@ -718,16 +1166,9 @@ namespace parse
                 >
         {};
 
-        struct segment_data
-            : pegtl::seq<
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                begin, TAO_PEGTL_ISTRING("Segment"), pegtl::eol,
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                header,
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                pegtl::sor< data_text, data_csv, data_binary_4, data_binary_8 >,
-                pegtl::star<pegtl::seq<empty_line, pegtl::eol>>,
-                pegtl::until<pegtl::seq<end, TAO_PEGTL_ISTRING("Segment")>>, pegtl::eol >
+        // A data block on its own, as located by the segment index
+        struct data_block
+            : pegtl::sor< data_text, data_csv, data_binary_4, data_binary_8 >
         {};
 
         ////////////////////////////////////
@@ -748,59 +1189,13 @@ namespace parse
         //     }
         // };
 
-        template<>
-        struct ovf_segment_data_action< line_data_txt >
-        {
-            template< typename Input, typename scalar >
-            static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
-            {
-                f._state->current_column = 0;
-                ++f._state->current_line;
-            }
-        };
-
-        template<>
-        struct ovf_segment_data_action< line_data_csv >
-        {
-            template< typename Input, typename scalar >
-            static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
-            {
-                f._state->current_column = 0;
-                ++f._state->current_line;
-            }
-        };
-
-        template<>
-        struct ovf_segment_data_action< text_value_float >
-        {
-            template< typename Input, typename scalar >
-            static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
-            {
-                int row = f._state->current_line;
-                int col = f._state->current_column;
-
-                int n_cols = segment.valuedim;
-
-                double value = std::stod(in.string());
-
-                int idx = col + row*n_cols;
-
-                if( idx < f._state->max_data_index )
-                {
-                    data[idx] = value;
-                    ++f._state->current_column;
-                }
-            }
-        };
-
         template<>
         struct ovf_segment_data_action< check_value_bin_4 >
         {
             template< typename Input, typename scalar >
             static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
             {
-                std::string bytes = in.string();
-                uint32_t hex_4b = endian::from_little_32(reinterpret_cast<const uint8_t *>( bytes.c_str() ));
+                uint32_t hex_4b = endian::from_little_32(reinterpret_cast<const uint8_t *>( in.begin() ));
 
                 if( hex_4b != check::val_4b )
                     throw tao::pegtl::parse_error( "the expected binary check value could not be parsed!", in );
@@ -813,25 +1208,14 @@ namespace parse
             template< typename Input, typename scalar >
             static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
             {
-                std::string bytes_str = in.string();
-                const uint8_t * bytes = reinterpret_cast<const uint8_t *>( bytes_str.c_str() );
-                for( int idx=0; idx < f._state->max_data_index; ++idx )
-                {
-                    uint32_t ivalue = endian::from_little_32( &bytes[4*idx] );
-                    float value = *reinterpret_cast<const float *>( &ivalue );
-
-                    if( idx < f._state->max_data_index )
-                    {
-                        data[idx] = value;
-                        ++f._state->current_column;
-                    }
+                // Decode straight from the input (i.e. the mapped file) into the data array
+                const uint8_t * bytes = reinterpret_cast<const uint8_t *>( in.begin() );
+                if( std::size_t(f._state->max_data_index) > in.size() / 4 )
+                    throw tao::pegtl::parse_error( fmt::format(
+                        "the data block contains only {} values, but {} were requested!",
+                        in.size() / 4, f._state->max_data_index), in );
 
-                    if( f._state->current_column > segment.valuedim )
-                    {
-                        f._state->current_column = 0;
-                        ++f._state->current_line;
-                    }
-                }
+                endian::from_little_32_array( bytes, data, f._state->max_data_index );
                 f._state->current_line = 0;
                 f._state->current_column = 0;
             }
@@ -843,8 +1227,7 @@ namespace parse
             template< typename Input, typename scalar >
             static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
             {
-                std::string bytes = in.string();
-                uint64_t hex_8b = endian::from_little_64(reinterpret_cast<const uint8_t *>( bytes.c_str() ));
+                uint64_t hex_8b = endian::from_little_64(reinterpret_cast<const uint8_t *>( in.begin() ));
 
                 if( hex_8b != check::val_8b )
                     throw tao::pegtl::parse_error( "the expected binary check value could not be parsed!", in );
@@ -857,25 +1240,14 @@ namespace parse
             template< typename Input, typename scalar >
             static void apply( const Input& in, ovf_file & f, const ovf_segment & segment, scalar * data )
             {
-                std::string bytes_str = in.string();
-                const uint8_t * bytes = reinterpret_cast<const uint8_t *>( bytes_str.c_str() );
-                for( int idx=0; idx < f._state->max_data_index; ++idx )
-                {
-                    uint64_t ivalue = endian::from_little_64( &bytes[8*idx] );
-                    double value = *reinterpret_cast<const double *>( &ivalue );
-
-                    if( idx < f._state->max_data_index )
-                    {
-                        data[idx] = value;
-                        ++f._state->current_column;
-                    }
+                // Decode straight from the input (i.e. the mapped file) into the data array
+                const uint8_t * bytes = reinterpret_cast<const uint8_t *>( in.begin() );
+                if( std::size_t(f._state->max_data_index) > in.size() / 8 )
+                    throw tao::pegtl::parse_error( fmt::format(
+                        "the data block contains only {} values, but {} were requested!",
+                        in.size() / 8, f._state->max_data_index), in );
 
-                    if( f._state->current_column > segment.valuedim )
-                    {
-                        f._state->current_column = 0;
-                        ++f._state->current_line;
-                    }
-                }
+                endian::from_little_64_array( bytes, data, f._state->max_data_index );
                 f._state->current_line = 0;
                 f._state->current_column = 0;
             }
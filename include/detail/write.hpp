@@ -8,9 +8,18 @@
 #include <fmt/format.h>
 
 #include <string>
+#include <type_traits>
 #include <vector>
-#include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <memory>
+#include <thread>
+#include <exception>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
 
 namespace ovf
 {
@@ -28,47 +37,163 @@ namespace write
     // This is needed so that, when appending, the file does not need to be overwritten
     static const int n_segments_str_digits = 6; // can store 1M modes
 
+    /*
+    Buffered output to a file. Everything goes through a buffer of fixed size, which is flushed
+    to the file whenever it is full, so the memory needed to write a segment does not depend on its size.
+    Except for the last one, writes end at multiples of write_alignment in the file, so that large
+    segments are written in whole file system blocks (or stripes on parallel file systems).
+    Failing to open or write the file throws.
+    */
     class file_handle
     {
-    private:
-        std::ofstream myfile;
     public:
-        file_handle(const std::string & filename, bool append);
+        static const std::size_t buffer_size     = 0x00400000; // 4[MByte]
+        static const std::size_t write_alignment = 0x00100000; // 1[MByte]
+
+        // Buffered writes at the current position of an open writer, through the given
+        // buffer of buffer_size bytes or an own one
+        file_handle(io::file_writer & writer, const std::string & filename, char * buffer = nullptr);
+        // Flushes the remaining buffer, errors are only reported by an explicit flush
         ~file_handle();
-        void write(const std::vector<std::string> & text);
-        void append(const std::vector<std::string> & text);
+
+        void write(const char * data, std::size_t size);
+        void write(const std::string & text);
+        // Write a large block of data straight from the given memory, together with what is buffered
+        void write_direct(const char * data, std::size_t size);
+        // Get space for up to buffer_size bytes at the end of the buffer, to be filled and then committed.
+        // Up to buffer_size - write_alignment bytes can be reserved without breaking the alignment of writes
+        char * reserve(std::size_t size);
+        void commit(std::size_t size);
+        // Write the buffer to the file
+        void flush();
+        // Allocate space in the file for the given number of bytes about to be written
+        void preallocate(std::size_t size);
+
+        // Offset in the file at which the next byte written through this handle ends up
+        std::size_t position() const;
+
+    private:
+        // Write the buffer up to the last aligned offset in the file, keeping the rest
+        void flush_aligned();
+
+        std::string filename;
+        io::file_writer & writer;
+        std::unique_ptr<char[]> own_buffer;
+        char * buffer;
+        std::size_t buffer_used = 0;
     };
 
-    inline file_handle::file_handle( const std::string & filename, bool append )
+    inline file_handle::file_handle( io::file_writer & writer, const std::string & filename, char * buffer )
+        : filename(filename), writer(writer), buffer(buffer)
     {
-        if( append )
-            myfile.open(filename, std::ofstream::out | std::ofstream::app);
-        else
-            myfile.open(filename);
+        if( !buffer )
+        {
+            own_buffer.reset( new char[buffer_size] );
+            this->buffer = own_buffer.get();
+        }
     }
 
 
     inline file_handle::~file_handle()
     {
-        myfile.close();
+        try
+        {
+            flush();
+        }
+        catch( ... )
+        {
+        }
     }
 
 
-    inline void file_handle::write(const std::vector<std::string> & text)
+    inline void file_handle::write(const char * data, std::size_t size)
     {
-        if( myfile.is_open() )
+        while( size > 0 )
         {
-            // Log(Log_Level::Debug, Log_Sender::All, "Started writing " + name);
-            for (int i = 0; i < text.size(); ++i)
-                myfile << text[i];
-
-            myfile.close();
-            // Log(Log_Level::Debug, Log_Sender::All, "Finished writing " + name);
+            std::size_t chunk = std::min( size, buffer_size - buffer_used );
+            std::memcpy( buffer + buffer_used, data, chunk );
+            buffer_used += chunk;
+            data        += chunk;
+            size        -= chunk;
+            if( buffer_used == buffer_size )
+                flush_aligned();
         }
-        else
+    }
+
+
+    inline void file_handle::write(const std::string & text)
+    {
+        write( text.data(), text.size() );
+    }
+
+
+    inline void file_handle::write_direct(const char * data, std::size_t size)
+    {
+        // Small blocks are cheaper to copy than to write separately
+        if( size < buffer_size / 4 )
         {
-            // Log(Log_Level::Error, Log_Sender::All, "Could not open " + name + " to write to file");
+            write( data, size );
+            return;
         }
+
+        // The unaligned end of the data is kept in the buffer, it is smaller than the data
+        std::size_t tail = ( position() + size ) % write_alignment;
+        io::buffer_view buffers[2] = { { buffer, buffer_used }, { data, size - tail } };
+        buffer_used = 0;
+        if( !writer.write( buffers, 2 ) )
+            throw std::runtime_error( fmt::format("could not write to file \"{}\"", filename) );
+        write( data + size - tail, tail );
+    }
+
+
+    inline char * file_handle::reserve(std::size_t size)
+    {
+        if( buffer_size - buffer_used < size )
+            flush_aligned();
+        if( buffer_size - buffer_used < size )
+            flush();
+        return buffer + buffer_used;
+    }
+
+
+    inline void file_handle::commit(std::size_t size)
+    {
+        buffer_used += size;
+    }
+
+
+    inline void file_handle::flush()
+    {
+        if( buffer_used == 0 )
+            return;
+        std::size_t size = buffer_used;
+        buffer_used = 0;
+        if( !writer.write( buffer, size ) )
+            throw std::runtime_error( fmt::format("could not write to file \"{}\"", filename) );
+    }
+
+
+    inline void file_handle::flush_aligned()
+    {
+        std::size_t size = buffer_used - std::min( buffer_used, position() % write_alignment );
+        if( size == 0 )
+            return;
+        if( !writer.write( buffer, size ) )
+            throw std::runtime_error( fmt::format("could not write to file \"{}\"", filename) );
+        std::memmove( buffer, buffer + size, buffer_used - size );
+        buffer_used -= size;
+    }
+
+
+    inline void file_handle::preallocate(std::size_t size)
+    {
+        writer.preallocate( position(), size );
+    }
+
+
+    inline std::size_t file_handle::position() const
+    {
+        return writer.position() + buffer_used;
     }
 
 
@@ -86,126 +211,350 @@ namespace write
     }
 
 
-    inline int increment_n_segments(ovf_file *file)
-    try
+    // Offset of the segment count within top_header_string()
+    inline std::size_t top_header_n_segments_pos()
     {
-        parse::file_header(*file);
+        return top_header_string().size() - n_segments_str_digits - 1;
+    }
 
-        // Update n_segments
-        file->n_segments++;
 
+    // Write the n_segments of the file into its header
+    inline int write_n_segments(ovf_file *file)
+    try
+    {
         // Convert updated n_segment into padded string
         std::string new_n_str = std::to_string( file->n_segments );
         std::string::size_type new_n_len = new_n_str.length();
         std::string::size_type padding_len = n_segments_str_digits - new_n_len;
         std::string padding( padding_len, '0' );
 
-        // Replace n_segments value in the stream
-        std::fstream filestream( file->file_name );
-        filestream.seekg( file->_state->n_segments_pos );
-        filestream << ( padding + new_n_str );
-        filestream.close();
+        // Replace n_segments value in the file
+        std::string n_str = padding + new_n_str;
+        if( !file->_state->writer.write_at( std::size_t(file->_state->n_segments_pos), n_str.data(), n_str.size() ) )
+        {
+            file->_state->message_latest = fmt::format("write_n_segments could not write to file \"{}\".", file->file_name);
+            return OVF_ERROR;
+        }
 
         return OVF_OK;
     }
     catch( ... )
+    {
+        file->_state->message_latest = fmt::format("write_n_segments failed for file \"{}\".", file->file_name);
+        return OVF_ERROR;
+    }
+
+    // Increment the n_segments of the file, which is only written into the file if write_count is set
+    inline int increment_n_segments(ovf_file *file, bool write_count = true)
+    try
+    {
+        // The position is known from opening or writing the file; only parse the header if not
+        if( file->_state->n_segments_pos == std::ios::pos_type(0) )
+            parse::file_header(*file);
+
+        // Update n_segments
+        file->n_segments++;
+
+        if( !write_count )
+            return OVF_OK;
+        return write_n_segments(file);
+    }
+    catch( ... )
     {
         file->_state->message_latest = fmt::format("increment_n_segments failed for file \"{}\".", file->file_name);
         return OVF_ERROR;
     }
 
 
+    /*
+    Sync the segments written since the last sync point, e.g. before the file is closed.
+    Their count is only written into the file afterwards, and then synced as well.
+    */
+    inline int sync_pending(ovf_file *file)
+    {
+        auto & state = *file->_state;
+        if( state.n_unsynced == 0 || !state.writer.is_open() )
+            return OVF_OK;
+        if( !state.writer.sync() || write_n_segments(file) != OVF_OK || !state.writer.sync() )
+        {
+            state.message_latest = fmt::format("could not sync file \"{}\"", file->file_name);
+            return OVF_ERROR;
+        }
+        state.n_unsynced = 0;
+        return OVF_OK;
+    }
+
+    /*
+    Save the sidecar index if segments were written since it was saved, when the file is closed.
+    It is not saved on every write, as it holds the whole index. The count in the file has to be up to date.
+    */
+    inline void save_changed_index(ovf_file *file)
+    {
+        auto & state = *file->_state;
+        if( state.index_changed && state.scan_complete && ( state.open_flags & OVF_OPEN_SIDECAR_INDEX ) &&
+            int(state.segment_index.size()) == file->n_segments )
+            parse::save_index(*file);
+        state.index_changed = false;
+    }
+
+
+    // Binary data is converted in blocks which fit into the buffer of the file handle
     template <typename T>
-    void append_data_bin_to_string( std::string & output_to_file, const T * vf, int n_cols, int n_rows, int format)
-    try
+    void write_data_bin( file_handle & handle, const T * vf, int n_cols, int n_rows, int format )
     {
+        std::size_t n_values = std::size_t(n_cols)*n_rows;
         if( format == OVF_FORMAT_BIN8 )
         {
-            auto out_check = std::vector<uint8_t>(8);
-            endian::to_little_64(check::val_8b, out_check.data());
-
-            output_to_file +=
-                std::string( reinterpret_cast<const char *>(out_check.data()), sizeof(double) );
+            uint8_t out_check[8];
+            endian::to_little_64(check::val_8b, out_check);
+            handle.write( reinterpret_cast<const char *>(out_check), sizeof(double) );
 
-            std::vector<uint8_t> out(n_cols*8);
-            for (unsigned int i=0; i<n_rows; ++i)
+            // The values are already laid out as in the file
+            if( endian::is_little() && std::is_same<T, double>::value )
+                handle.write_direct( reinterpret_cast<const char *>(vf), n_values*sizeof(double) );
+            else
             {
-                for (int j=0; j<n_cols; ++j)
+                const std::size_t block = ( file_handle::buffer_size - file_handle::write_alignment ) / sizeof(double);
+                for( std::size_t i = 0; i < n_values; i += block )
                 {
-                    double val = static_cast<double>(vf[n_cols*i + j]);
-                    uint64_t in = *reinterpret_cast<uint64_t*>(&val);
-
-                    endian::to_little_64(in, &out[j*8]);
+                    std::size_t n = std::min( block, n_values - i );
+                    char * out = handle.reserve( n*sizeof(double) );
+                    endian::to_little_64_array( vf + i, reinterpret_cast<uint8_t *>(out), n );
+                    handle.commit( n*sizeof(double) );
                 }
-                output_to_file +=
-                    std::string( reinterpret_cast<char *>(out.data()), n_cols*sizeof(double) );
             }
         }
         else if( format == OVF_FORMAT_BIN4 )
         {
-            auto out_check = std::vector<uint8_t>(4);
-            endian::to_little_32(check::val_4b, out_check.data());
-
-            output_to_file +=
-                std::string( reinterpret_cast<const char *>(out_check.data()), sizeof(float) );
+            uint8_t out_check[4];
+            endian::to_little_32(check::val_4b, out_check);
+            handle.write( reinterpret_cast<const char *>(out_check), sizeof(float) );
 
-            std::vector<uint8_t> out(n_cols*4);
-            for (unsigned int i=0; i<n_rows; ++i)
+            // The values are already laid out as in the file
+            if( endian::is_little() && std::is_same<T, float>::value )
+                handle.write_direct( reinterpret_cast<const char *>(vf), n_values*sizeof(float) );
+            else
             {
-                for (int j=0; j<n_cols; ++j)
+                const std::size_t block = ( file_handle::buffer_size - file_handle::write_alignment ) / sizeof(float);
+                for( std::size_t i = 0; i < n_values; i += block )
                 {
-                    float val = static_cast<float>(vf[n_cols*i + j]);
-                    uint32_t in = *reinterpret_cast<uint32_t*>(&val);
-
-                    endian::to_little_32(in, &out[j*4]);
+                    std::size_t n = std::min( block, n_values - i );
+                    char * out = handle.reserve( n*sizeof(float) );
+                    endian::to_little_32_array( vf + i, reinterpret_cast<uint8_t *>(out), n );
+                    handle.commit( n*sizeof(float) );
                 }
-                output_to_file +=
-                    std::string( reinterpret_cast<char *>(out.data()), n_cols*sizeof(float) );
             }
         }
 
-        output_to_file += "\n";
+        handle.write( "\n", 1 );
     }
-    catch( ... )
+
+
+    // In-memory output with the same interface as file_handle, used to format chunks of rows in parallel
+    class memory_output
     {
+    public:
+        void write(const char * data, std::size_t size)
+        {
+            std::memcpy( reserve(size), data, size );
+            used += size;
+        }
+        char * reserve(std::size_t size)
+        {
+            if( buffer.size() < used + size )
+                buffer.resize( used + size );
+            return &buffer[used];
+        }
+        void commit(std::size_t size) { used += size; }
+        void clear()                  { used = 0; }
 
-    }
+        const char * data() const { return buffer.data(); }
+        std::size_t size() const  { return used; }
 
+    private:
+        std::string buffer;
+        std::size_t used = 0;
+    };
 
-    template <typename T>
-    void append_data_txt_to_string( std::string & output_to_file, const T * vf, int n_cols, int n_rows,
-        const std::string& delimiter = "" )
-    try
+
+    /*
+    Text data is formatted row by row straight into the buffer of the output.
+    Rows containing values which the fixed-point formatter does not handle (very large or not finite)
+    are formatted with fmt instead, which produces the same text.
+    */
+    template <typename Output, typename T>
+    void write_rows_txt( Output & out, const T * vf, int n_cols, int row_begin, int row_end,
+        const std::string& delimiter )
     {
-        for (int row = 0; row < n_rows; ++row)
+        const std::size_t max_row_size = std::size_t(n_cols) * ( number::fixed_max_size + delimiter.size() ) + 1;
+        const bool fast = max_row_size <= file_handle::buffer_size;
+
+        fmt::memory_buffer row_buffer;
+        for (int row = row_begin; row < row_end; ++row)
         {
+            if( fast )
+            {
+                char * row_out = out.reserve( max_row_size );
+                std::size_t row_size = 0;
+                int col = 0;
+                for( ; col < n_cols; ++col )
+                {
+                    std::size_t length = number::format_fixed_12( vf[n_cols*row + col], row_out + row_size );
+                    if( length == 0 )
+                        break;
+                    row_size += length;
+                    std::memcpy( row_out + row_size, delimiter.data(), delimiter.size() );
+                    row_size += delimiter.size();
+                }
+                if( col == n_cols )
+                {
+                    row_out[row_size++] = '\n';
+                    out.commit( row_size );
+                    continue;
+                }
+            }
+
+            row_buffer.clear();
             for (int col = 0; col < n_cols; ++col)
-                output_to_file += fmt::format( "{:22.12f}{}", vf[n_cols*row + col], delimiter );
-            output_to_file += "\n";
+                fmt::format_to( row_buffer, "{:22.12f}{}", vf[n_cols*row + col], delimiter );
+            row_buffer.push_back( '\n' );
+            out.write( row_buffer.data(), row_buffer.size() );
         }
     }
-    catch( ... )
+
+
+    /*
+    Text data can be formatted by several threads. The rows are split into chunks, which the worker threads
+    format into a ring of buffers while the calling thread writes the formatted chunks in order, so the output
+    is the same as with a single thread, writing overlaps with formatting and the memory needed stays bounded.
+    The workers are started once per segment. rows_per_chunk = 0 aims for chunks of about the size of the file buffer.
+    */
+    template <typename T>
+    void write_data_txt( file_handle & handle, const T * vf, int n_cols, int n_rows,
+        const std::string& delimiter = "", int n_threads = 1, int rows_per_chunk = 0 )
     {
+        // Assume the typical 22 characters per value
+        if( rows_per_chunk <= 0 )
+            rows_per_chunk = int( std::max( std::size_t(1),
+                file_handle::buffer_size / ( std::size_t(n_cols) * ( number::fixed_width + delimiter.size() ) + 1 ) ) );
 
+        if( n_threads <= 1 || n_rows <= rows_per_chunk )
+        {
+            write_rows_txt( handle, vf, n_cols, 0, n_rows, delimiter );
+            return;
+        }
+
+        struct chunk_slot
+        {
+            memory_output out;
+            bool formatted = false;
+            std::exception_ptr error;
+        };
+
+        // Chunk c is formatted into slot c % n_slots, once chunk c - n_slots was written from it
+        const long long n_chunks = ( (long long)n_rows + rows_per_chunk - 1 ) / rows_per_chunk;
+        const long long n_slots  = 2 * (long long)n_threads;
+        std::vector<chunk_slot> slots( n_slots );
+        long long next_formatted = 0;
+        long long next_written   = 0;
+        bool stop = false;
+        std::mutex mutex;
+        std::condition_variable chunk_formatted, chunk_written;
+
+        auto format_chunks = [&]()
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            while( true )
+            {
+                chunk_written.wait( lock, [&]{ return stop || next_formatted >= n_chunks || next_formatted < next_written + n_slots; } );
+                if( stop || next_formatted >= n_chunks )
+                    return;
+                const long long chunk = next_formatted++;
+                chunk_slot & slot = slots[chunk % n_slots];
+                lock.unlock();
+
+                try
+                {
+                    slot.out.clear();
+                    int row_begin = int( chunk * rows_per_chunk );
+                    int row_end   = int( std::min( (long long)row_begin + rows_per_chunk, (long long)n_rows ) );
+                    write_rows_txt( slot.out, vf, n_cols, row_begin, row_end, delimiter );
+                }
+                catch( ... )
+                {
+                    slot.error = std::current_exception();
+                }
+
+                lock.lock();
+                slot.formatted = true;
+                chunk_formatted.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        std::exception_ptr error;
+        try
+        {
+            for( int thread = 0; thread < n_threads; ++thread )
+                workers.emplace_back( format_chunks );
+
+            for( long long chunk = 0; chunk < n_chunks; ++chunk )
+            {
+                chunk_slot & slot = slots[chunk % n_slots];
+                {
+                    std::unique_lock<std::mutex> lock( mutex );
+                    chunk_formatted.wait( lock, [&]{ return slot.formatted; } );
+                }
+                if( slot.error )
+                    std::rethrow_exception( slot.error );
+                handle.write( slot.out.data(), slot.out.size() );
+
+                std::lock_guard<std::mutex> lock( mutex );
+                slot.formatted = false;
+                next_written = chunk + 1;
+                chunk_written.notify_all();
+            }
+        }
+        catch( ... )
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            stop = true;
+        }
+        chunk_written.notify_all();
+        for( auto & worker : workers )
+            worker.join();
+        if( error )
+            std::rethrow_exception( error );
     }
 
 
-    template <typename T>
-    int segment( ovf_file *file, const ovf_segment * segment, const T * vf,
-                const bool append = false, int format = OVF_FORMAT_BIN8 )
-    try
+    // The rendered header of a segment, which can be written any number of times
+    struct segment_header
     {
-        if( file->_state->file_contents.size() > 0 && append )
-            file->_state->file_contents.push_back("");
-        else
-            file->_state->file_contents = {""};
+        // From the empty line before "# Begin: Segment" up to the empty line after "# End: Header"
+        std::string text;
+        // Index entry of the segment with its shape, offsets are relative to the beginning of the text
+        segment_index_entry entry;
+        int n_cols = 0;
+        int n_rows = 0;
+    };
 
-        int index = file->_state->file_contents.size()-1;
-        std::string & output_to_file = file->_state->file_contents[index];
-        output_to_file.reserve( int( 0x08000000 ) );  // reserve 128[MByte]
+
+    inline int render_header( ovf_file *file, const ovf_segment * segment, segment_header & header )
+    try
+    {
+        std::string & output_to_file = header.text;
+        segment_index_entry & entry = header.entry;
+        output_to_file.clear();
+        entry = segment_index_entry();
 
         output_to_file += fmt::format( empty_line );
         output_to_file += fmt::format( "# Begin: Segment\n" );
+        entry.header_begin = output_to_file.size();
         output_to_file += fmt::format( "# Begin: Header\n" );
         output_to_file += fmt::format( empty_line );
 
@@ -312,8 +661,48 @@ namespace write
 
         output_to_file += fmt::format( empty_line );
         output_to_file += fmt::format( "# End: Header\n" );
+        entry.header_end = output_to_file.size();
         output_to_file += fmt::format( empty_line );
 
+        entry.valuedim = n_cols;
+        entry.N        = n_rows;
+        if( meshtype == "rectangular" )
+        {
+            entry.n_cells[0] = segment->n_cells[0];
+            entry.n_cells[1] = segment->n_cells[1];
+            entry.n_cells[2] = segment->n_cells[2];
+        }
+        else
+            entry.pointcount = segment->pointcount;
+
+        header.n_cols = n_cols;
+        header.n_rows = n_rows;
+        return OVF_OK;
+    }
+    catch( const std::exception & ex )
+    {
+        file->_state->message_latest = fmt::format("Caught std::exception \"{}\"", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        return OVF_ERROR;
+    }
+
+
+    /*
+    Write a segment with a rendered header and the given data, either replacing the contents
+    of the file or appending to it. The buffer is used to stream the data, if one is given.
+    */
+    template <typename T>
+    int segment( ovf_file *file, const segment_header & header, const T * vf,
+                const bool append, int format, char * buffer = nullptr )
+    try
+    {
+        segment_index_entry entry = header.entry;
+        const int n_cols = header.n_cols;
+        const int n_rows = header.n_rows;
+
         if( sizeof(T) == sizeof(float) && format == OVF_FORMAT_BIN )
             format = OVF_FORMAT_BIN4;
         else if( sizeof(T) == sizeof(double) && format == OVF_FORMAT_BIN )
@@ -329,43 +718,247 @@ namespace write
         else if( format == OVF_FORMAT_CSV )
             datatype_out = "CSV";
 
-        // Data
-        output_to_file += fmt::format( "# Begin: Data {}\n", datatype_out );
-
-        if ( format == OVF_FORMAT_BIN || format == OVF_FORMAT_BIN8 || format == OVF_FORMAT_BIN4 )
-            append_data_bin_to_string( output_to_file, vf, n_cols, n_rows, format );
-        else if ( format == OVF_FORMAT_TEXT )
-            append_data_txt_to_string( output_to_file, vf, n_cols, n_rows );
-        else if ( format == OVF_FORMAT_CSV )
-            append_data_txt_to_string( output_to_file, vf, n_cols, n_rows, "," );
-        else
+        if( datatype_out == "" )
         {
             file->_state->message_latest = fmt::format(
                 "write_segment not writing out any data, because format \"{}\" is invalid. "
                 "You may want to check what you passed in.", format);
             return OVF_ERROR;
         }
-        output_to_file += fmt::format( "# End: Data {}\n", datatype_out );
-        output_to_file += fmt::format( "# End: Segment\n" );
 
-        // Append the #End keywords
-        if( append )
+        // Data
+        std::string data_begin = fmt::format( "# Begin: Data {}\n", datatype_out );
+        entry.data_begin = header.text.size();
+        entry.payload_begin = entry.data_begin + data_begin.size();
+        if( format == OVF_FORMAT_BIN8 )
+            entry.payload_begin += sizeof(double);
+        else if( format == OVF_FORMAT_BIN4 )
+            entry.payload_begin += sizeof(float);
+
+        entry.format = format;
+
+        if( !append )
         {
-            file_handle handle(file->file_name, true);
-            handle.write( {output_to_file} );
+            // The file is truncated, so the old mapping must not be accessed any more
+            if( !file->_state->data_views.empty() )
+            {
+                file->_state->message_latest = fmt::format(
+                    "write_segment cannot overwrite file \"{}\" while {} data views into it are held",
+                    file->file_name, file->_state->data_views.size());
+                return OVF_ERROR;
+            }
+            file->_state->mapping.close();
+            file->_state->segment_index.clear();
         }
-        else
+
+        io::file_writer & writer = file->_state->writer;
+        if( !append || !writer.is_open() )
+        {
+            if( !writer.open(file->file_name, append) )
+            {
+                file->_state->message_latest = fmt::format(
+                    "write_segment could not open file \"{}\" for writing", file->file_name);
+                return OVF_ERROR;
+            }
+        }
+
+        /*
+        A lazily opened file is scanned to its end before the first append. The count in the file may lag
+        behind the complete segments (e.g. with a sync interval), and what an interrupted append left behind
+        needs to be found.
+        */
+        if( append && !file->_state->scan_complete )
         {
-            file_handle handle(file->file_name, false);
+            while( parse::scan_next_segment(*file) )
+            {
+            }
+            file->n_segments = std::max( file->n_segments, int(file->_state->segment_index.size()) );
+        }
+
+        // Drop what an interrupted append left after the last complete segment
+        std::size_t & recovered_end = file->_state->recovered_end;
+        if( append && recovered_end > 0 && writer.position() > recovered_end && !writer.truncate(recovered_end) )
+        {
+            file->_state->message_latest = fmt::format(
+                "write_segment could not cut off the incomplete end of file \"{}\"", file->file_name);
+            return OVF_ERROR;
+        }
+        recovered_end = 0;
+
+        file_handle handle(writer, file->file_name, buffer);
+        if( !append )
+        {
+            handle.write( top_header_string() );
             file->n_segments = 0;
             file->version = 2;
-            handle.write( {top_header_string(), output_to_file} );
+            file->_state->n_segments_pos = top_header_n_segments_pos();
+            file->_state->scan_complete = true;
+        }
+        std::size_t offset = handle.position();
+
+        // The size of binary segments is known up front
+        const std::string data_end = fmt::format( "# End: Data {}\n", datatype_out );
+        const std::string segment_end = "# End: Segment\n";
+        if( format == OVF_FORMAT_BIN8 || format == OVF_FORMAT_BIN4 )
+        {
+            std::size_t value_size = format == OVF_FORMAT_BIN8 ? sizeof(double) : sizeof(float);
+            handle.preallocate( header.text.size() + data_begin.size()
+                + value_size * ( 1 + std::size_t(n_cols)*n_rows ) + 1 + data_end.size() + segment_end.size() );
         }
+
+        // Header, data and the #End keywords
+        handle.write( header.text );
+        handle.write( data_begin );
+        if( format == OVF_FORMAT_BIN8 || format == OVF_FORMAT_BIN4 )
+            write_data_bin( handle, vf, n_cols, n_rows, format );
+        else if( format == OVF_FORMAT_TEXT )
+            write_data_txt( handle, vf, n_cols, n_rows, "", file->_state->write_threads );
+        else if( format == OVF_FORMAT_CSV )
+            write_data_txt( handle, vf, n_cols, n_rows, ",", file->_state->write_threads );
+        handle.write( data_end );
+        entry.data_end = handle.position() - offset;
+        handle.write( segment_end );
+        entry.end = handle.position() - offset;
+        handle.flush();
+
+        /*
+        If syncing is enabled, the count is only updated at sync points: the segments are synced before
+        the count includes them and the count is synced afterwards, so a crash cannot leave a count that
+        covers data which is not on the storage device. Creating a file is always a sync point.
+        */
+        auto & state = *file->_state;
+        bool sync = state.sync_interval > 0 && ( !append || ++state.n_unsynced >= state.sync_interval );
+        if( sync && ( !writer.sync() || ( !append && !io::sync_directory(file->file_name) ) ) )
+        {
+            state.message_latest = fmt::format("write_segment could not sync file \"{}\"", file->file_name);
+            return OVF_ERROR;
+        }
+
+        entry.begin         += offset;
+        entry.end           += offset;
+        entry.header_begin  += offset;
+        entry.header_end    += offset;
+        entry.data_begin    += offset;
+        entry.data_end      += offset;
+        entry.payload_begin += offset;
+        // If a lazily opened file has not been scanned to the end yet, the scan will find the new segment
+        if( file->_state->scan_complete )
+            file->_state->segment_index.push_back(entry);
         file->found  = true;
         file->is_ovf = true;
 
         // Increment the n_segments after succesfully appending the segment body to the file
-        return increment_n_segments(file);
+        const bool write_count = state.sync_interval == 0 || sync;
+        int retcode = increment_n_segments(file, write_count);
+        if( retcode == OVF_OK && sync )
+        {
+            if( !writer.sync() )
+            {
+                state.message_latest = fmt::format("write_segment could not sync file \"{}\"", file->file_name);
+                return OVF_ERROR;
+            }
+            state.n_unsynced = 0;
+        }
+
+        // The sidecar index is saved when the file is closed
+        if( retcode == OVF_OK )
+            file->_state->index_changed = true;
+
+        return retcode;
+    }
+    catch( const std::exception & ex )
+    {
+        file->_state->message_latest = fmt::format("Caught std::exception \"{}\"", ex.what());
+        return OVF_ERROR;
+    }
+    catch( ... )
+    {
+        return OVF_ERROR;
+    }
+
+
+    template <typename T>
+    int segment( ovf_file *file, const ovf_segment * segment, const T * vf,
+                const bool append = false, int format = OVF_FORMAT_BIN8 )
+    {
+        segment_header header;
+        if( render_header( file, segment, header ) != OVF_OK )
+            return OVF_ERROR;
+        return write::segment( file, header, vf, append, format );
+    }
+
+
+    /*
+    Replace the values of a binary segment in place, leaving the rest of the file untouched.
+    The segment must have the shape of the one in the file, the values are converted to its format.
+    */
+    template <typename T>
+    int overwrite_data( ovf_file *file, int index, const ovf_segment * segment, const T * vf )
+    try
+    {
+        int retcode = parse::binary_data_block( *file, index, "overwrite_segment_data" );
+        if( retcode != OVF_OK )
+            return retcode;
+        const segment_index_entry entry = file->_state->segment_index[index];
+
+        bool irregular = std::string(segment->meshtype) == "irregular";
+        bool same_shape = segment->valuedim == entry.valuedim;
+        if( irregular )
+            same_shape = same_shape && segment->pointcount == entry.N;
+        else
+            same_shape = same_shape && segment->n_cells[0] == entry.n_cells[0] &&
+                segment->n_cells[1] == entry.n_cells[1] && segment->n_cells[2] == entry.n_cells[2] &&
+                std::size_t(segment->n_cells[0])*segment->n_cells[1]*segment->n_cells[2] == std::size_t(entry.N);
+        if( !same_shape )
+        {
+            file->_state->message_latest = fmt::format(
+                "overwrite_segment_data: the shape of the segment does not match segment {} of file \"{}\"",
+                index, file->file_name);
+            return OVF_INVALID;
+        }
+
+        io::file_writer & writer = file->_state->writer;
+        if( !writer.is_open() && !writer.open(file->file_name, true) )
+        {
+            file->_state->message_latest = fmt::format(
+                "overwrite_segment_data could not open file \"{}\" for writing", file->file_name);
+            return OVF_ERROR;
+        }
+
+        const std::size_t n_values   = std::size_t(entry.N) * entry.valuedim;
+        const std::size_t value_size = entry.format == OVF_FORMAT_BIN8 ? sizeof(double) : sizeof(float);
+        bool success = true;
+        if( endian::is_little() && sizeof(T) == value_size )
+        {
+            // The values are already laid out as in the file
+            success = writer.write_at( entry.payload_begin, reinterpret_cast<const char *>(vf), n_values*value_size );
+        }
+        else
+        {
+            const std::size_t block = std::min( n_values, file_handle::buffer_size / value_size );
+            std::unique_ptr<uint8_t[]> converted( new uint8_t[block*value_size] );
+            for( std::size_t i = 0; success && i < n_values; i += block )
+            {
+                std::size_t n = std::min( block, n_values - i );
+                if( value_size == sizeof(double) )
+                    endian::to_little_64_array( vf + i, converted.get(), n );
+                else
+                    endian::to_little_32_array( vf + i, converted.get(), n );
+                success = writer.write_at( entry.payload_begin + i*value_size,
+                    reinterpret_cast<const char *>(converted.get()), n*value_size );
+            }
+        }
+        if( !success || ( file->_state->sync_interval > 0 && !writer.sync() ) )
+        {
+            file->_state->message_latest = fmt::format(
+                "overwrite_segment_data could not write to file \"{}\"", file->file_name);
+            return OVF_ERROR;
+        }
+
+        // The modification time changed, the sidecar index is saved when the file is closed
+        file->_state->index_changed = true;
+
+        return OVF_OK;
     }
     catch( const std::exception & ex )
     {
@@ -376,8 +969,201 @@ namespace write
     {
         return OVF_ERROR;
     }
+
+
+    /*
+    Writes segments in a background thread, in the order in which they were queued.
+    The data of each segment is copied into one of a fixed number of slots, so queuing
+    only has to wait while all of them are still waiting to be written.
+    Once a segment could not be written, the ones queued after it are discarded and
+    nothing more is accepted, as the file may be left inconsistent.
+    */
+    class async_writer
+    {
+    public:
+        // Writes the data of one segment, returning OVF_OK or OVF_ERROR and a message
+        using write_function = std::function<int( const char * data, bool is_double, std::string & message )>;
+
+        async_writer( int n_slots, write_function write );
+        // Writes all queued segments before returning
+        ~async_writer();
+
+        // Copy the data of a segment into a free slot. Returns false if an earlier segment could not be written
+        bool queue( const char * data, std::size_t size, bool is_double, int frame );
+        // Wait until all queued segments are written. Returns false if any failed since the last wait
+        bool wait();
+        // Wait until all queued segments are written, without reporting on them
+        void drain();
+        // Add to the messages, which are cleared when they are taken
+        void report( const std::string & text );
+        std::string take_message();
+
+    private:
+        struct slot
+        {
+            std::vector<char> data;
+            bool is_double = false;
+            int frame = 0;
+        };
+
+        void run();
+
+        write_function write;
+        std::vector<slot> slots;
+        // The oldest queued slot and the number of queued slots
+        std::size_t first    = 0;
+        std::size_t n_queued = 0;
+        bool failed            = false;
+        bool failed_since_wait = false;
+        bool stop              = false;
+        std::string message;
+
+        std::mutex mutex;
+        // Notified when a slot was queued or when stopping, and when a slot was written
+        std::condition_variable slot_queued;
+        std::condition_variable slot_written;
+        std::thread thread;
+    };
+
+
+    inline async_writer::async_writer( int n_slots, write_function write )
+        : write(write), slots(n_slots)
+    {
+        thread = std::thread( &async_writer::run, this );
+    }
+
+
+    inline async_writer::~async_writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        slot_queued.notify_one();
+        thread.join();
+    }
+
+
+    inline bool async_writer::queue( const char * data, std::size_t size, bool is_double, int frame )
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        slot_written.wait( lock, [this]{ return n_queued < slots.size() || failed; } );
+        if( failed )
+            return false;
+
+        // The background thread does not touch slots until they are queued
+        slot & next = slots[( first + n_queued ) % slots.size()];
+        lock.unlock();
+        next.data.assign( data, data + size );
+        next.is_double = is_double;
+        next.frame     = frame;
+        lock.lock();
+
+        ++n_queued;
+        lock.unlock();
+        slot_queued.notify_one();
+        return true;
+    }
+
+
+    inline bool async_writer::wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        slot_written.wait( lock, [this]{ return n_queued == 0; } );
+        bool success = !failed_since_wait;
+        failed_since_wait = false;
+        return success;
+    }
+
+
+    inline void async_writer::drain()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        slot_written.wait( lock, [this]{ return n_queued == 0; } );
+    }
+
+
+    inline void async_writer::report( const std::string & text )
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if( !message.empty() )
+            message += "\n";
+        message += text;
+    }
+
+
+    inline std::string async_writer::take_message()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::string ret;
+        ret.swap( message );
+        return ret;
+    }
+
+
+    inline void async_writer::run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while( true )
+        {
+            slot_queued.wait( lock, [this]{ return n_queued > 0 || stop; } );
+            if( n_queued == 0 )
+                return;
+
+            slot & current = slots[first];
+            bool discard = failed;
+            lock.unlock();
+            std::string text;
+            int retcode = OVF_ERROR;
+            if( !discard )
+            {
+                try
+                {
+                    retcode = write( current.data.data(), current.is_double, text );
+                }
+                catch( const std::exception & ex )
+                {
+                    text = ex.what();
+                }
+                catch( ... )
+                {
+                }
+            }
+            lock.lock();
+
+            if( !message.empty() && ( discard || retcode != OVF_OK ) )
+                message += "\n";
+            if( discard )
+                message += fmt::format( "segment {} was discarded, because an earlier one could not be written", current.frame );
+            else if( retcode != OVF_OK )
+            {
+                message += fmt::format( "segment {} could not be written: {}", current.frame, text );
+                failed = true;
+                failed_since_wait = true;
+            }
+            first = ( first + 1 ) % slots.size();
+            --n_queued;
+            slot_written.notify_all();
+        }
+    }
 }
 }
 }
 
+// A file with a rendered segment header, to which segments of that shape are appended
+struct ovf_writer
+{
+    ovf_file file;
+    ovf::detail::write::segment_header header{};
+    int format = OVF_FORMAT_BIN;
+    // Used to stream the data of every segment
+    std::unique_ptr<char[]> buffer{};
+
+    // Number of segments appended so far
+    int n_appended = 0;
+    // If set, segments are written in the background and the file must not be touched otherwise
+    std::unique_ptr<ovf::detail::write::async_writer> async{};
+    std::string message_out{};
+};
+
 #endif
\ No newline at end of file
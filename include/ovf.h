@@ -31,6 +31,19 @@
 #define OVF_FORMAT_TEXT  3
 #define OVF_FORMAT_CSV   4
 
+/* flags for opening a file */
+#define OVF_OPEN_DEFAULT        0
+/* use the sidecar index file (<name>.ovfidx) if it is up to date, and write it otherwise.
+    It holds the location and the parsed header of each segment, so neither needs to be parsed again.
+    Segments written through the file are added to it when the file is closed */
+#define OVF_OPEN_SIDECAR_INDEX  1
+/* parse only the file header and locate segments on demand, when they are first accessed */
+#define OVF_OPEN_LAZY           2
+/* accept a file with fewer complete segments than its segment count says, e.g. after a crash while
+    appending without syncing every segment. Only the complete segments are used, and appending
+    continues after the last of them, cutting off the rest of the file */
+#define OVF_OPEN_RECOVER        4
+
 /* all header info on a segment */
 struct ovf_segment {
     char *title;
@@ -84,6 +97,10 @@ DLLEXPORT struct ovf_file * ovf_open(const char *filename);
 /* opening a file will fill the struct and prepare everything for read/write */
 DLLEXPORT void ovf_file_initialize(struct ovf_file *, const char *filename);
 
+/* same as ovf_open and ovf_file_initialize, but with a combination of OVF_OPEN_* flags */
+DLLEXPORT struct ovf_file * ovf_open_flags(const char *filename, int flags);
+DLLEXPORT void ovf_file_initialize_flags(struct ovf_file *, const char *filename, int flags);
+
 /* create a default-initialized segment struct */
 DLLEXPORT struct ovf_segment * ovf_segment_create();
 
@@ -98,6 +115,46 @@ DLLEXPORT int ovf_read_segment_header(struct ovf_file *, int index, struct ovf_s
 DLLEXPORT int ovf_read_segment_data_4(struct ovf_file *, int index, const struct ovf_segment *, float *data);
 DLLEXPORT int ovf_read_segment_data_8(struct ovf_file *, int index, const struct ovf_segment *, double *data);
 
+/* Read the data of the segments first <= index < first + count, which all have to have the shape of the passed segment,
+    into one contiguous array of count*segment->N*segment->valuedim values, one segment after the other.
+    The headers are not parsed again for this */
+DLLEXPORT int ovf_read_segments_4(struct ovf_file *, int first, int count, const struct ovf_segment *, float *data);
+DLLEXPORT int ovf_read_segments_8(struct ovf_file *, int first, int count, const struct ovf_segment *, double *data);
+
+/* Read only the cells first_cell <= cell < first_cell + count of a segment, which has to have the valuedim of the passed segment.
+    Binary data is read straight from the range, text data is parsed only up to the end of the range */
+DLLEXPORT int ovf_read_segment_range_4(struct ovf_file *, int index, const struct ovf_segment *, int first_cell, int count, float *data);
+DLLEXPORT int ovf_read_segment_range_8(struct ovf_file *, int index, const struct ovf_segment *, int first_cell, int count, double *data);
+
+/* Read only some of the components of the data of a segment, e.g. only z of a vector field.
+    Bit i of component_mask selects component i. The data array holds the selected components of each cell,
+    one cell after the other, for the first segment->N cells */
+DLLEXPORT int ovf_read_segment_components_4(struct ovf_file *, int index, const struct ovf_segment *, int component_mask, float *data);
+DLLEXPORT int ovf_read_segment_components_8(struct ovf_file *, int index, const struct ovf_segment *, int component_mask, double *data);
+
+/* Read only the cells lo <= (x,y,z) < hi of a segment on a rectangular mesh, which has to match the passed segment.
+    The data array holds the valuedim values of each cell of the region, with x running fastest.
+    Only the rows of the region are read from the file */
+DLLEXPORT int ovf_read_segment_region_4(struct ovf_file *, int index, const struct ovf_segment *, const int lo[3], const int hi[3], float *data);
+DLLEXPORT int ovf_read_segment_region_8(struct ovf_file *, int index, const struct ovf_segment *, const int lo[3], const int hi[3], double *data);
+
+/* Read a subsampled preview of a segment on a rectangular mesh, which has to match the passed segment:
+    every stride[dim]-th cell along each axis, starting at the first one.
+    The data array holds the valuedim values of ceil(n_cells[dim] / stride[dim]) cells per axis, with x running fastest.
+    Only the sampled cells are read from binary data */
+DLLEXPORT int ovf_read_segment_strided_4(struct ovf_file *, int index, const struct ovf_segment *, const int stride[3], float *data);
+DLLEXPORT int ovf_read_segment_strided_8(struct ovf_file *, int index, const struct ovf_segment *, const int stride[3], double *data);
+
+/* Zero-copy access to the data of a segment stored in binary in the byte order of the host.
+    On success, *data points to the (*count) values directly in the file and *format is OVF_FORMAT_BIN4
+    (float) or OVF_FORMAT_BIN8 (double). The data is read-only and may not be aligned.
+    Returns OVF_INVALID if the segment cannot be viewed directly (text or CSV data, or a big endian host),
+    in which case ovf_read_segment_data_4 or _8 needs to be used, and OVF_ERROR if it holds more values than fit into *count.
+    Each view stays valid until it is released, releasing a pointer which is not a held view returns OVF_ERROR. Views must be released before the file is closed,
+    and the file cannot be overwritten by ovf_write_segment_4 or _8 while views are held. */
+DLLEXPORT int ovf_segment_data_view(struct ovf_file *, int index, const void **data, int *count, int *format);
+DLLEXPORT int ovf_segment_data_view_release(struct ovf_file *, const void *data);
+
 /* write a segment (header and data) to the file, overwriting all contents.
     The new header will have segment count = 1 */
 DLLEXPORT int ovf_write_segment_4(struct ovf_file *, const struct ovf_segment *, float *data, int format=OVF_FORMAT_BIN);
@@ -108,11 +165,66 @@ DLLEXPORT int ovf_write_segment_8(struct ovf_file *, const struct ovf_segment *,
 DLLEXPORT int ovf_append_segment_4(struct ovf_file *, const struct ovf_segment *, float *data, int format=OVF_FORMAT_BIN);
 DLLEXPORT int ovf_append_segment_8(struct ovf_file *, const struct ovf_segment *, double *data, int format=OVF_FORMAT_BIN);
 
+/* Replace the data of an existing binary segment in place, without touching the rest of the file.
+    The segment has to have the same shape (valuedim and n_cells or pointcount) as the one in the file,
+    the data is converted to the format of the file. Returns OVF_INVALID if the segment in the file
+    does not match or is not stored in binary. Data views of the segment see the new data */
+DLLEXPORT int ovf_overwrite_segment_data_4(struct ovf_file *, int index, const struct ovf_segment *, const float *data);
+DLLEXPORT int ovf_overwrite_segment_data_8(struct ovf_file *, int index, const struct ovf_segment *, const double *data);
+
+/* set the number of threads used to format Text and CSV data when writing segments (default 1).
+    0 uses as many threads as the hardware supports. The output does not depend on the number of threads */
+DLLEXPORT int ovf_set_write_threads(struct ovf_file *, int n_threads);
+
+/* Flush written segments to the storage device (fdatasync) every n_segments segments.
+    0 (the default) never syncs, 1 syncs every segment. The segment count in the file is only updated
+    at these sync points, after the segments are synced, so that a crash does not leave a count which
+    includes a segment that was not written completely. Segments after the last sync may be lost in a crash,
+    complete ones which are not counted yet are still found when the file is opened, see OVF_OPEN_RECOVER.
+    Segments which are not synced yet are synced and counted when the file is closed */
+DLLEXPORT int ovf_set_sync_interval(struct ovf_file *, int n_segments);
+
 /* retrieve the most recent error message and clear it */
 DLLEXPORT const char * ovf_latest_message(struct ovf_file *);
 
 /* close the file and clean up resources */
 DLLEXPORT int ovf_close(struct ovf_file *);
 
+/* opaque handle for appending many segments of the same shape to a file */
+struct ovf_writer;
+
+/* Open a file for appending segments which all share the header of the given segment
+    (title, geometry, units, ...) and are written in the given format.
+    The header is rendered only once. If the file is an OVF file, the segments are appended to it;
+    if it does not exist, it is created with the first segment.
+    Returns a null pointer if the segment or format are invalid or if the file is not an OVF file. */
+DLLEXPORT struct ovf_writer * ovf_writer_open(const char *filename, const struct ovf_segment *, int format=OVF_FORMAT_BIN);
+
+/* append a segment with the given data, which has the shape of the segment the writer was opened with.
+    The segment count will be incremented */
+DLLEXPORT int ovf_writer_append_4(struct ovf_writer *, const float *data);
+DLLEXPORT int ovf_writer_append_8(struct ovf_writer *, const double *data);
+
+/* Write the segments appended to a writer in a background thread, in order.
+    The data passed to ovf_writer_append_4 or _8 is copied into one of n_buffers buffers and the call
+    returns right away, unless all buffers are still waiting to be written.
+    Errors of segments written in the background are reported by ovf_writer_wait and ovf_writer_close,
+    and segments appended after an error are discarded.
+    0 buffers makes appending synchronous again, after the pending segments are written. */
+DLLEXPORT int ovf_writer_set_async(struct ovf_writer *, int n_buffers);
+
+/* flush the segments of a writer to the storage device every n_segments segments, see ovf_set_sync_interval */
+DLLEXPORT int ovf_writer_set_sync_interval(struct ovf_writer *, int n_segments);
+
+/* wait until all segments appended to a writer are written.
+    Returns OVF_ERROR if any of them could not be written since the last wait */
+DLLEXPORT int ovf_writer_wait(struct ovf_writer *);
+
+/* retrieve the most recent error message of a writer and clear it */
+DLLEXPORT const char * ovf_writer_latest_message(struct ovf_writer *);
+
+/* write the pending segments, close the file of a writer and free the writer */
+DLLEXPORT int ovf_writer_close(struct ovf_writer *);
+
 #undef DLLEXPORT
 #endif
\ No newline at end of file
@@ -4,8 +4,19 @@
 #include <detail/write.hpp>
 #include <fmt/format.h>
 
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <cstdlib>
+
 
 void ovf_file_initialize(struct ovf_file * ovf_file_ptr, const char * filename)
+{
+    ovf_file_initialize_flags(ovf_file_ptr, filename, OVF_OPEN_DEFAULT);
+}
+
+
+void ovf_file_initialize_flags(struct ovf_file * ovf_file_ptr, const char * filename, int flags)
 try
 {
     // Initialize the struct
@@ -15,11 +26,11 @@ try
     ovf_file_ptr->is_ovf     = false;
     ovf_file_ptr->n_segments = 0;
     ovf_file_ptr->_state     = new parser_state;
+    ovf_file_ptr->_state->open_flags = flags;
 
     // Check if the file exists
-    std::fstream filestream( filename );
-    ovf_file_ptr->found = filestream.is_open();
-    filestream.close();
+    ovf::detail::io::file_status status;
+    ovf_file_ptr->found = ovf::detail::io::get_file_status( filename, status );
 
     // Parse the overall header and do the initial parse of segments
     if( ovf_file_ptr->found )
@@ -31,11 +42,17 @@ catch( ... )
 
 
 struct ovf_file * ovf_open(const char * filename)
+{
+    return ovf_open_flags(filename, OVF_OPEN_DEFAULT);
+}
+
+
+struct ovf_file * ovf_open_flags(const char * filename, int flags)
 try
 {
     // Initialize the struct
     struct ovf_file * ovf_file_ptr = new ovf_file;
-    ovf_file_initialize(ovf_file_ptr, filename);
+    ovf_file_initialize_flags(ovf_file_ptr, filename, flags);
     return ovf_file_ptr;
 }
 catch( ... )
@@ -290,7 +307,7 @@ catch( ... )
 }
 
 
-int ovf_write_segment_4(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, float *data, int format)
+int ovf_read_segments_4(struct ovf_file *ovf_file_ptr, int first, int count, const struct ovf_segment *segment, float *data)
 try
 {
     if( !ovf_file_ptr )
@@ -299,40 +316,43 @@ try
     if( !segment )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_write_segment_4: invalid segment pointer";
+            "libovf ovf_read_segments_4: invalid segment pointer";
         return OVF_ERROR;
     }
 
     if( !check_segment(segment) )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_write_segment_4: segment not correctly initialized";
+            "libovf ovf_read_segments_4: segment not correctly initialized";
         return OVF_ERROR;
     }
 
     if( !data )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_write_segment_4: invalid data pointer";
+            "libovf ovf_read_segments_4: invalid data pointer";
         return OVF_ERROR;
     }
 
-    if( format == OVF_FORMAT_BIN8 ||
-        format == OVF_FORMAT_BIN4 )
-        format = OVF_FORMAT_BIN;
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segments_4: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
 
-    if( format != OVF_FORMAT_BIN  &&
-        format != OVF_FORMAT_TEXT &&
-        format != OVF_FORMAT_CSV  )
+    if( first < 0 || count <= 0 || count > ovf_file_ptr->n_segments - first )
     {
-        ovf_file_ptr->_state->message_latest =
-            fmt::format("libovf ovf_write_segment_4: invalid format \'{}\'...", format);
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segments_4: invalid range of {} segments from index {}, n_segments ({}) of file \'{}\'...",
+            count, first, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
         return OVF_ERROR;
     }
 
-    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, false, format);
-    if (retcode != OVF_OK)
-        ovf_file_ptr->_state->message_latest += "\novf_write_segment_4 failed.";
+    int retcode = ovf::detail::parse::segments_data(*ovf_file_ptr, first, count, *segment, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segments_4 failed.";
     return retcode;
 }
 catch( ... )
@@ -341,7 +361,7 @@ catch( ... )
 }
 
 
-int ovf_write_segment_8(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, double *data, int format)
+int ovf_read_segments_8(struct ovf_file *ovf_file_ptr, int first, int count, const struct ovf_segment *segment, double *data)
 try
 {
     if( !ovf_file_ptr )
@@ -350,40 +370,43 @@ try
     if( !segment )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_write_segment_8: invalid segment pointer";
+            "libovf ovf_read_segments_8: invalid segment pointer";
         return OVF_ERROR;
     }
 
     if( !check_segment(segment) )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_write_segment_8: segment not correctly initialized";
+            "libovf ovf_read_segments_8: segment not correctly initialized";
         return OVF_ERROR;
     }
 
     if( !data )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_write_segment_8: invalid data pointer";
+            "libovf ovf_read_segments_8: invalid data pointer";
         return OVF_ERROR;
     }
 
-    if( format == OVF_FORMAT_BIN8 ||
-        format == OVF_FORMAT_BIN4 )
-        format = OVF_FORMAT_BIN;
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segments_8: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
 
-    if( format != OVF_FORMAT_BIN  &&
-        format != OVF_FORMAT_TEXT &&
-        format != OVF_FORMAT_CSV  )
+    if( first < 0 || count <= 0 || count > ovf_file_ptr->n_segments - first )
     {
-        ovf_file_ptr->_state->message_latest =
-            fmt::format("libovf ovf_write_segment_8: invalid format \'{}\'...", format);
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segments_8: invalid range of {} segments from index {}, n_segments ({}) of file \'{}\'...",
+            count, first, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
         return OVF_ERROR;
     }
 
-    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, false, format);
-    if (retcode != OVF_OK)
-        ovf_file_ptr->_state->message_latest += "\novf_write_segment_8 failed.";
+    int retcode = ovf::detail::parse::segments_data(*ovf_file_ptr, first, count, *segment, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segments_8 failed.";
     return retcode;
 }
 catch( ... )
@@ -392,7 +415,8 @@ catch( ... )
 }
 
 
-int ovf_append_segment_4(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, float *data, int format)
+int ovf_read_segment_range_4(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    int first_cell, int count, float *data)
 try
 {
     if( !ovf_file_ptr )
@@ -401,47 +425,98 @@ try
     if( !segment )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_append_segment_4: invalid segment pointer";
+            "libovf ovf_read_segment_range_4: invalid segment pointer";
         return OVF_ERROR;
     }
 
     if( !check_segment(segment) )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_append_segment_4: segment not correctly initialized";
+            "libovf ovf_read_segment_range_4: segment not correctly initialized";
         return OVF_ERROR;
     }
 
     if( !data )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_append_segment_4: invalid data pointer";
+            "libovf ovf_read_segment_range_4: invalid data pointer";
         return OVF_ERROR;
     }
 
-    if( ovf_file_ptr->found && !ovf_file_ptr->is_ovf )
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
     {
-        ovf_file_ptr->_state->message_latest = "libovf ovf_append_segment_4: file is not ovf...";
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_range_4: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
         return OVF_ERROR;
     }
 
-    if( format == OVF_FORMAT_BIN8 ||
-        format == OVF_FORMAT_BIN4 )
-        format = OVF_FORMAT_BIN;
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_range_4: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
 
-    if( format != OVF_FORMAT_BIN  &&
-        format != OVF_FORMAT_TEXT &&
-        format != OVF_FORMAT_CSV  )
+    int retcode = ovf::detail::parse::segment_data_range(*ovf_file_ptr, index, *segment, first_cell, count, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_range_4 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_read_segment_range_8(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    int first_cell, int count, double *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
     {
         ovf_file_ptr->_state->message_latest =
-            fmt::format("libovf ovf_append_segment_4: invalid format \'{}\'...", format);
+            "libovf ovf_read_segment_range_8: invalid segment pointer";
         return OVF_ERROR;
     }
 
-    bool append = ovf_file_ptr->found;
-    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, append, format);
-    if (retcode != OVF_OK)
-        ovf_file_ptr->_state->message_latest += "\novf_append_segment_4 failed.";
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_range_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_range_8: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_range_8: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_range_8: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::parse::segment_data_range(*ovf_file_ptr, index, *segment, first_cell, count, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_range_8 failed.";
     return retcode;
 }
 catch( ... )
@@ -450,7 +525,8 @@ catch( ... )
 }
 
 
-int ovf_append_segment_8(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, double *data, int format)
+int ovf_read_segment_components_4(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    int component_mask, float *data)
 try
 {
     if( !ovf_file_ptr )
@@ -459,47 +535,100 @@ try
     if( !segment )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_append_segment_8: invalid segment pointer";
+            "libovf ovf_read_segment_components_4: invalid segment pointer";
         return OVF_ERROR;
     }
 
     if( !check_segment(segment) )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_append_segment_8: segment not correctly initialized";
+            "libovf ovf_read_segment_components_4: segment not correctly initialized";
         return OVF_ERROR;
     }
 
     if( !data )
     {
         ovf_file_ptr->_state->message_latest =
-            "libovf ovf_append_segment_8: invalid data pointer";
+            "libovf ovf_read_segment_components_4: invalid data pointer";
         return OVF_ERROR;
     }
 
-    if( format == OVF_FORMAT_BIN8 ||
-        format == OVF_FORMAT_BIN4 )
-        format = OVF_FORMAT_BIN;
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_components_4: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
 
-    if( ovf_file_ptr->found && !ovf_file_ptr->is_ovf )
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
     {
-        ovf_file_ptr->_state->message_latest = "libovf ovf_append_segment_8: file is not ovf...";
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_components_4: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
         return OVF_ERROR;
     }
 
-    if( format != OVF_FORMAT_BIN  &&
-        format != OVF_FORMAT_TEXT &&
-        format != OVF_FORMAT_CSV  )
+    unsigned long long components = static_cast<unsigned int>(component_mask);
+    int retcode = ovf::detail::parse::segment_data_components(*ovf_file_ptr, index, *segment, components, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_components_4 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_read_segment_components_8(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    int component_mask, double *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
     {
         ovf_file_ptr->_state->message_latest =
-            fmt::format("libovf ovf_append_segment_8: invalid format \'{}\'...", format);
+            "libovf ovf_read_segment_components_8: invalid segment pointer";
         return OVF_ERROR;
     }
 
-    bool append = ovf_file_ptr->found;
-    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, append, format);
-    if (retcode != OVF_OK)
-        ovf_file_ptr->_state->message_latest += "\novf_append_segment_8 failed.";
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_components_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_components_8: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_components_8: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_components_8: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    unsigned long long components = static_cast<unsigned int>(component_mask);
+    int retcode = ovf::detail::parse::segment_data_components(*ovf_file_ptr, index, *segment, components, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_components_8 failed.";
     return retcode;
 }
 catch( ... )
@@ -508,33 +637,933 @@ catch( ... )
 }
 
 
-const char * ovf_latest_message(struct ovf_file *ovf_file_ptr)
+int ovf_read_segment_region_4(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    const int lo[3], const int hi[3], float *data)
 try
 {
     if( !ovf_file_ptr )
-        return "";
+        return OVF_ERROR;
 
-    ovf_file_ptr->_state->message_out = ovf_file_ptr->_state->message_latest;
-    ovf_file_ptr->_state->message_latest = "";
-    return ovf_file_ptr->_state->message_out.c_str();
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_region_4: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_region_4: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !lo || !hi || !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_region_4: invalid region or data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_region_4: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_region_4: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::parse::segment_data_region(*ovf_file_ptr, index, *segment, lo, hi, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_region_4 failed.";
+    return retcode;
 }
 catch( ... )
 {
-    return "";
+    return OVF_ERROR;
 }
 
 
-int ovf_close(struct ovf_file * ovf_file_ptr)
+int ovf_read_segment_region_8(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    const int lo[3], const int hi[3], double *data)
 try
 {
     if( !ovf_file_ptr )
         return OVF_ERROR;
-    if( !ovf_file_ptr->_state )
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_region_8: invalid segment pointer";
         return OVF_ERROR;
-    delete(ovf_file_ptr->_state);
-    return OVF_OK;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_region_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !lo || !hi || !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_region_8: invalid region or data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_region_8: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_region_8: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::parse::segment_data_region(*ovf_file_ptr, index, *segment, lo, hi, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_region_8 failed.";
+    return retcode;
 }
 catch( ... )
 {
     return OVF_ERROR;
-}
\ No newline at end of file
+}
+
+
+int ovf_read_segment_strided_4(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    const int stride[3], float *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_strided_4: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_strided_4: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !stride || !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_strided_4: invalid stride or data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_strided_4: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_strided_4: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::parse::segment_data_strided(*ovf_file_ptr, index, *segment, stride, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_strided_4 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_read_segment_strided_8(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment,
+    const int stride[3], double *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_strided_8: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_strided_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !stride || !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_read_segment_strided_8: invalid stride or data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_strided_8: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_read_segment_strided_8: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::parse::segment_data_strided(*ovf_file_ptr, index, *segment, stride, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_read_segment_strided_8 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_write_segment_4(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, float *data, int format)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_write_segment_4: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_write_segment_4: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_write_segment_4: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( format == OVF_FORMAT_BIN8 ||
+        format == OVF_FORMAT_BIN4 )
+        format = OVF_FORMAT_BIN;
+
+    if( format != OVF_FORMAT_BIN  &&
+        format != OVF_FORMAT_TEXT &&
+        format != OVF_FORMAT_CSV  )
+    {
+        ovf_file_ptr->_state->message_latest =
+            fmt::format("libovf ovf_write_segment_4: invalid format \'{}\'...", format);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, false, format);
+    if (retcode != OVF_OK)
+        ovf_file_ptr->_state->message_latest += "\novf_write_segment_4 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_write_segment_8(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, double *data, int format)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_write_segment_8: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_write_segment_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_write_segment_8: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( format == OVF_FORMAT_BIN8 ||
+        format == OVF_FORMAT_BIN4 )
+        format = OVF_FORMAT_BIN;
+
+    if( format != OVF_FORMAT_BIN  &&
+        format != OVF_FORMAT_TEXT &&
+        format != OVF_FORMAT_CSV  )
+    {
+        ovf_file_ptr->_state->message_latest =
+            fmt::format("libovf ovf_write_segment_8: invalid format \'{}\'...", format);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, false, format);
+    if (retcode != OVF_OK)
+        ovf_file_ptr->_state->message_latest += "\novf_write_segment_8 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_append_segment_4(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, float *data, int format)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_append_segment_4: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_append_segment_4: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_append_segment_4: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( ovf_file_ptr->found && !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = "libovf ovf_append_segment_4: file is not ovf...";
+        return OVF_ERROR;
+    }
+
+    if( format == OVF_FORMAT_BIN8 ||
+        format == OVF_FORMAT_BIN4 )
+        format = OVF_FORMAT_BIN;
+
+    if( format != OVF_FORMAT_BIN  &&
+        format != OVF_FORMAT_TEXT &&
+        format != OVF_FORMAT_CSV  )
+    {
+        ovf_file_ptr->_state->message_latest =
+            fmt::format("libovf ovf_append_segment_4: invalid format \'{}\'...", format);
+        return OVF_ERROR;
+    }
+
+    bool append = ovf_file_ptr->found;
+    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, append, format);
+    if (retcode != OVF_OK)
+        ovf_file_ptr->_state->message_latest += "\novf_append_segment_4 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_append_segment_8(struct ovf_file *ovf_file_ptr, const struct ovf_segment *segment, double *data, int format)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_append_segment_8: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_append_segment_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_append_segment_8: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( format == OVF_FORMAT_BIN8 ||
+        format == OVF_FORMAT_BIN4 )
+        format = OVF_FORMAT_BIN;
+
+    if( ovf_file_ptr->found && !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = "libovf ovf_append_segment_8: file is not ovf...";
+        return OVF_ERROR;
+    }
+
+    if( format != OVF_FORMAT_BIN  &&
+        format != OVF_FORMAT_TEXT &&
+        format != OVF_FORMAT_CSV  )
+    {
+        ovf_file_ptr->_state->message_latest =
+            fmt::format("libovf ovf_append_segment_8: invalid format \'{}\'...", format);
+        return OVF_ERROR;
+    }
+
+    bool append = ovf_file_ptr->found;
+    int retcode = ovf::detail::write::segment(ovf_file_ptr, segment, data, append, format);
+    if (retcode != OVF_OK)
+        ovf_file_ptr->_state->message_latest += "\novf_append_segment_8 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_overwrite_segment_data_4(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment, const float *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_overwrite_segment_data_4: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_overwrite_segment_data_4: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_overwrite_segment_data_4: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_overwrite_segment_data_4: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_overwrite_segment_data_4: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::write::overwrite_data(ovf_file_ptr, index, segment, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_overwrite_segment_data_4 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_overwrite_segment_data_8(struct ovf_file *ovf_file_ptr, int index, const struct ovf_segment *segment, const double *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !segment )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_overwrite_segment_data_8: invalid segment pointer";
+        return OVF_ERROR;
+    }
+
+    if( !check_segment(segment) )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_overwrite_segment_data_8: segment not correctly initialized";
+        return OVF_ERROR;
+    }
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_overwrite_segment_data_8: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found || !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_overwrite_segment_data_8: file \'{}\' does not exist or is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_overwrite_segment_data_8: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::write::overwrite_data(ovf_file_ptr, index, segment, data);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_overwrite_segment_data_8 failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_segment_data_view(struct ovf_file *ovf_file_ptr, int index, const void **data, int *count, int *format)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !data || !count || !format )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_segment_data_view: invalid output pointer";
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->found )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_segment_data_view: file \'{}\' does not exist...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( !ovf_file_ptr->is_ovf )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_segment_data_view: file \'{}\' is not ovf...",
+            ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    if( index < 0 || index >= ovf_file_ptr->n_segments )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_segment_data_view: invalid index ({}), n_segments ({}) of file \'{}\'...",
+            index, ovf_file_ptr->n_segments, ovf_file_ptr->file_name);
+        return OVF_ERROR;
+    }
+
+    int retcode = ovf::detail::parse::segment_data_view(*ovf_file_ptr, index, *data, *count, *format);
+    if( retcode != OVF_OK )
+        ovf_file_ptr->_state->message_latest += "\novf_segment_data_view failed.";
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_segment_data_view_release(struct ovf_file *ovf_file_ptr, const void *data)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( !data )
+    {
+        ovf_file_ptr->_state->message_latest =
+            "libovf ovf_segment_data_view_release: invalid data pointer";
+        return OVF_ERROR;
+    }
+
+    return ovf::detail::parse::segment_data_view_release(*ovf_file_ptr, data);
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_set_write_threads(struct ovf_file *ovf_file_ptr, int n_threads)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( n_threads < 0 )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_set_write_threads: invalid number of threads ({})", n_threads);
+        return OVF_ERROR;
+    }
+
+    if( n_threads == 0 )
+        n_threads = std::max( 1u, std::thread::hardware_concurrency() );
+    ovf_file_ptr->_state->write_threads = n_threads;
+    return OVF_OK;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_set_sync_interval(struct ovf_file *ovf_file_ptr, int n_segments)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+
+    if( n_segments < 0 )
+    {
+        ovf_file_ptr->_state->message_latest = fmt::format(
+            "libovf ovf_set_sync_interval: invalid number of segments ({})", n_segments);
+        return OVF_ERROR;
+    }
+
+    ovf_file_ptr->_state->sync_interval = n_segments;
+    return OVF_OK;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+const char * ovf_latest_message(struct ovf_file *ovf_file_ptr)
+try
+{
+    if( !ovf_file_ptr )
+        return "";
+
+    ovf_file_ptr->_state->message_out = ovf_file_ptr->_state->message_latest;
+    ovf_file_ptr->_state->message_latest = "";
+    return ovf_file_ptr->_state->message_out.c_str();
+}
+catch( ... )
+{
+    return "";
+}
+
+
+int ovf_close(struct ovf_file * ovf_file_ptr)
+try
+{
+    if( !ovf_file_ptr )
+        return OVF_ERROR;
+    if( !ovf_file_ptr->_state )
+        return OVF_ERROR;
+    int retcode = ovf::detail::write::sync_pending(ovf_file_ptr);
+    if( retcode == OVF_OK )
+        ovf::detail::write::save_changed_index(ovf_file_ptr);
+    delete(ovf_file_ptr->_state);
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+struct ovf_writer * ovf_writer_open(const char *filename, const struct ovf_segment *segment, int format)
+try
+{
+    if( !filename || !segment || !check_segment(segment) )
+        return nullptr;
+
+    if( format != OVF_FORMAT_BIN  && format != OVF_FORMAT_BIN4 && format != OVF_FORMAT_BIN8 &&
+        format != OVF_FORMAT_TEXT && format != OVF_FORMAT_CSV )
+        return nullptr;
+
+    std::unique_ptr<ovf_writer> writer( new ovf_writer() );
+    // Only the file header is needed to append, the segments in the file are not located
+    ovf_file_initialize_flags(&writer->file, filename, OVF_OPEN_LAZY);
+    if( !writer->file._state )
+        return nullptr;
+
+    if( ( writer->file.found && !writer->file.is_ovf ) ||
+        ovf::detail::write::render_header(&writer->file, segment, writer->header) != OVF_OK )
+    {
+        ovf_close(&writer->file);
+        free( const_cast<char *>(writer->file.file_name) );
+        return nullptr;
+    }
+
+    writer->format = format;
+    writer->buffer.reset( new char[ovf::detail::write::file_handle::buffer_size] );
+    return writer.release();
+}
+catch( ... )
+{
+    return nullptr;
+}
+
+
+// Append a segment to a writer, either writing it directly or queuing it for the background thread
+template <typename T>
+int writer_append(struct ovf_writer *writer, const T *data, const char *function_name)
+{
+    if( !data )
+    {
+        std::string message = fmt::format("libovf {}: invalid data pointer", function_name);
+        if( writer->async )
+            writer->async->report(message);
+        else
+            writer->file._state->message_latest = message;
+        return OVF_ERROR;
+    }
+
+    int frame = writer->n_appended++;
+    if( writer->async )
+    {
+        std::size_t size = std::size_t(writer->header.n_cols) * writer->header.n_rows * sizeof(T);
+        if( !writer->async->queue(reinterpret_cast<const char *>(data), size, sizeof(T) == sizeof(double), frame) )
+        {
+            writer->n_appended--;
+            writer->async->report(fmt::format(
+                "libovf {}: not appending, because an earlier segment could not be written", function_name));
+            return OVF_ERROR;
+        }
+        return OVF_OK;
+    }
+
+    bool append = writer->file.found;
+    int retcode = ovf::detail::write::segment(&writer->file, writer->header, data, append, writer->format, writer->buffer.get());
+    if (retcode != OVF_OK)
+        writer->file._state->message_latest += fmt::format("\n{} failed.", function_name);
+    return retcode;
+}
+
+
+int ovf_writer_append_4(struct ovf_writer *writer, const float *data)
+try
+{
+    if( !writer )
+        return OVF_ERROR;
+    return writer_append(writer, data, "ovf_writer_append_4");
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_writer_append_8(struct ovf_writer *writer, const double *data)
+try
+{
+    if( !writer )
+        return OVF_ERROR;
+    return writer_append(writer, data, "ovf_writer_append_8");
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+// Wait for the background thread of a writer to finish and stop it, keeping its messages
+int writer_stop_async(struct ovf_writer *writer)
+{
+    if( !writer->async )
+        return OVF_OK;
+
+    int retcode = writer->async->wait() ? OVF_OK : OVF_ERROR;
+    std::string message = writer->async->take_message();
+    writer->async.reset();
+    if( !message.empty() )
+        writer->file._state->message_latest = message;
+    return retcode;
+}
+
+
+int ovf_writer_set_async(struct ovf_writer *writer, int n_buffers)
+try
+{
+    if( !writer )
+        return OVF_ERROR;
+
+    if( n_buffers < 0 )
+    {
+        std::string message = fmt::format("libovf ovf_writer_set_async: invalid number of buffers ({})", n_buffers);
+        if( writer->async )
+            writer->async->report(message);
+        else
+            writer->file._state->message_latest = message;
+        return OVF_ERROR;
+    }
+
+    int retcode = writer_stop_async(writer);
+    if( n_buffers > 0 )
+    {
+        // From now on, only the background thread accesses the file
+        std::string message = writer->file._state->message_latest;
+        writer->file._state->message_latest = "";
+        writer->async.reset( new ovf::detail::write::async_writer( n_buffers,
+            [writer]( const char * data, bool is_double, std::string & message )
+            {
+                bool append = writer->file.found;
+                int retcode = OVF_OK;
+                if( is_double )
+                    retcode = ovf::detail::write::segment(&writer->file, writer->header,
+                        reinterpret_cast<const double *>(data), append, writer->format, writer->buffer.get());
+                else
+                    retcode = ovf::detail::write::segment(&writer->file, writer->header,
+                        reinterpret_cast<const float *>(data), append, writer->format, writer->buffer.get());
+                if( retcode != OVF_OK )
+                    message = ovf_latest_message(&writer->file);
+                return retcode;
+            } ) );
+        if( !message.empty() )
+            writer->async->report(message);
+    }
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_writer_set_sync_interval(struct ovf_writer *writer, int n_segments)
+try
+{
+    if( !writer )
+        return OVF_ERROR;
+
+    if( !writer->async )
+        return ovf_set_sync_interval(&writer->file, n_segments);
+
+    if( n_segments < 0 )
+    {
+        writer->async->report(fmt::format(
+            "libovf ovf_writer_set_sync_interval: invalid number of segments ({})", n_segments));
+        return OVF_ERROR;
+    }
+
+    // The background thread only accesses the file while segments are pending
+    writer->async->drain();
+    writer->file._state->sync_interval = n_segments;
+    return OVF_OK;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+int ovf_writer_wait(struct ovf_writer *writer)
+try
+{
+    if( !writer )
+        return OVF_ERROR;
+    if( !writer->async )
+        return OVF_OK;
+    return writer->async->wait() ? OVF_OK : OVF_ERROR;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
+
+
+const char * ovf_writer_latest_message(struct ovf_writer *writer)
+try
+{
+    if( !writer )
+        return "";
+    if( !writer->async )
+        return ovf_latest_message(&writer->file);
+
+    writer->message_out = writer->async->take_message();
+    return writer->message_out.c_str();
+}
+catch( ... )
+{
+    return "";
+}
+
+
+int ovf_writer_close(struct ovf_writer *writer)
+try
+{
+    if( !writer )
+        return OVF_ERROR;
+    // All segments that were appended are written before closing
+    int retcode = writer_stop_async(writer);
+    if( ovf_close(&writer->file) != OVF_OK )
+        retcode = OVF_ERROR;
+    free( const_cast<char *>(writer->file.file_name) );
+    delete writer;
+    return retcode;
+}
+catch( ... )
+{
+    return OVF_ERROR;
+}
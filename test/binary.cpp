@@ -3,6 +3,9 @@
 #include <ovf.h>
 
 #include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstring>
 
 
 TEST_CASE( "Binary", "[binary]" )
@@ -318,4 +321,146 @@ TEST_CASE( "Mixed binary and CSV", "[mixed]" )
         // close
         ovf_close(file);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Data view", "[view]" )
+{
+    const char * testfile = "testfile_cpp_view.ovf";
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4;
+
+    // data
+    std::vector<double> field(3*segment->N, 1);
+    std::vector<float> field_4(3*segment->N, 2);
+    field[0] = 3;
+    field_4[0] = 5;
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    REQUIRE( ovf_append_segment_4(file, segment, field_4.data(), OVF_FORMAT_BIN) == OVF_OK );
+    ovf_close(file);
+
+    file = ovf_open(testfile);
+    REQUIRE( file->n_segments == 3 );
+
+    const void * data = nullptr;
+    int count = 0, format = 0;
+    int success = ovf_segment_data_view(file, 0, &data, &count, &format);
+    if( OVF_OK != success )
+        std::cerr << ovf_latest_message(file) << std::endl;
+    REQUIRE( success == OVF_OK );
+    REQUIRE( count == 12 );
+    REQUIRE( format == OVF_FORMAT_BIN8 );
+    // the pointer may not be aligned
+    std::vector<double> field_read(count);
+    std::memcpy( field_read.data(), data, count*sizeof(double) );
+    REQUIRE( field_read == field );
+
+    const void * data_4 = nullptr;
+    REQUIRE( ovf_segment_data_view(file, 2, &data_4, &count, &format) == OVF_OK );
+    REQUIRE( format == OVF_FORMAT_BIN4 );
+    std::vector<float> field_read_4(count);
+    std::memcpy( field_read_4.data(), data_4, count*sizeof(float) );
+    REQUIRE( field_read_4 == field_4 );
+
+    // text data cannot be viewed
+    const void * data_text = nullptr;
+    REQUIRE( ovf_segment_data_view(file, 1, &data_text, &count, &format) == OVF_INVALID );
+
+    // appending keeps the views valid, overwriting is not possible while they are held
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    REQUIRE( ovf_read_segment_data_8(file, 3, segment, field_read.data()) == OVF_OK );
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_ERROR );
+    std::memcpy( field_read.data(), data, count*sizeof(double) );
+    REQUIRE( field_read == field );
+
+    // each view is released only once, unknown pointers are not views
+    const void * data_again = nullptr;
+    REQUIRE( ovf_segment_data_view(file, 0, &data_again, &count, &format) == OVF_OK );
+    REQUIRE( ovf_segment_data_view_release(file, data) == OVF_OK );
+    REQUIRE( ovf_segment_data_view_release(file, data) == OVF_ERROR );
+    REQUIRE( ovf_segment_data_view_release(file, field.data()) == OVF_ERROR );
+
+    // the other views are still held
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_ERROR );
+    REQUIRE( ovf_segment_data_view_release(file, data_again) == OVF_OK );
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_ERROR );
+    REQUIRE( ovf_segment_data_view_release(file, data_4) == OVF_OK );
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    REQUIRE( file->n_segments == 1 );
+    ovf_close(file);
+}
+
+TEST_CASE( "Overwrite in place", "[overwrite]" )
+{
+    const char * testfile = "testfile_cpp_overwrite.ovf";
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 4;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 8;
+
+    // data
+    std::vector<double> field(3*segment->N, 1);
+    std::vector<float> field_4(3*segment->N, 2);
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    REQUIRE( ovf_append_segment_4(file, segment, field_4.data(), OVF_FORMAT_BIN) == OVF_OK );
+    ovf_close(file);
+
+    std::ifstream in(testfile, std::ios::binary | std::ios::ate);
+    auto size = in.tellg();
+    in.close();
+
+    file = ovf_open(testfile);
+    for( std::size_t i = 0; i < field.size(); ++i )
+    {
+        field[i]   = 0.5*i;
+        field_4[i] = 0.25f*i;
+    }
+
+    // the data is converted to the format of the segment in the file
+    REQUIRE( ovf_overwrite_segment_data_8(file, 0, segment, field.data()) == OVF_OK );
+    REQUIRE( ovf_overwrite_segment_data_8(file, 2, segment, field.data()) == OVF_OK );
+
+    // text data cannot be overwritten in place, and the shape has to match
+    REQUIRE( ovf_overwrite_segment_data_8(file, 1, segment, field.data()) == OVF_INVALID );
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 4;
+    REQUIRE( ovf_overwrite_segment_data_4(file, 0, segment, field_4.data()) == OVF_INVALID );
+    segment->n_cells[0] = 4;
+    segment->n_cells[1] = 2;
+    REQUIRE( ovf_overwrite_segment_data_4(file, 3, segment, field_4.data()) == OVF_ERROR );
+
+    std::vector<double> field_read(3*segment->N);
+    REQUIRE( ovf_read_segment_data_8(file, 0, segment, field_read.data()) == OVF_OK );
+    REQUIRE( field_read == field );
+    ovf_close(file);
+
+    // only the data was replaced
+    in.open(testfile, std::ios::binary | std::ios::ate);
+    REQUIRE( in.tellg() == size );
+    in.close();
+
+    file = ovf_open(testfile);
+    REQUIRE( file->n_segments == 3 );
+    std::vector<float> field_read_4(3*segment->N);
+    REQUIRE( ovf_read_segment_data_4(file, 2, segment, field_read_4.data()) == OVF_OK );
+    for( std::size_t i = 0; i < field.size(); ++i )
+        REQUIRE( field_read_4[i] == float(field[i]) );
+    REQUIRE( ovf_read_segment_data_8(file, 1, segment, field_read.data()) == OVF_OK );
+    REQUIRE( field_read == std::vector<double>(3*segment->N, 1) );
+    ovf_close(file);
+}
@@ -1,8 +1,14 @@
 #include <catch.hpp>
 
 #include <ovf.h>
+#include <detail/write.hpp>
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <string>
+#include <iterator>
 
 TEST_CASE( "NonExistent", "[nonexistent]" )
 {
@@ -229,4 +235,1067 @@ TEST_CASE( "Read", "[read]" )
         // close
         ovf_close(file);
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE( "Read back", "[readback]" )
+{
+    const char * testfile = "testfile_cpp_readback.ovf";
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4;
+
+    // data
+    std::vector<double> field(3*segment->N, 1);
+    field[0] = 3;
+    field[9] = 0;
+
+    // write and append through the same handle
+    auto file = ovf_open(testfile);
+    int success = ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT);
+    REQUIRE( success == OVF_OK );
+    field[0] = 6;
+    success = ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN);
+    REQUIRE( success == OVF_OK );
+    REQUIRE( file->n_segments == 2 );
+
+    // read both segments back through the same handle
+    for( int index = 0; index < 2; ++index )
+    {
+        auto segment_read = ovf_segment_create();
+        success = ovf_read_segment_header(file, index, segment_read);
+        if( OVF_OK != success )
+            std::cerr << ovf_latest_message(file) << std::endl;
+        REQUIRE( success == OVF_OK );
+        REQUIRE( segment_read->N == 4 );
+
+        std::vector<double> field_read(3*segment_read->N);
+        success = ovf_read_segment_data_8(file, index, segment_read, field_read.data());
+        if( OVF_OK != success )
+            std::cerr << ovf_latest_message(file) << std::endl;
+        REQUIRE( success == OVF_OK );
+        REQUIRE( field_read[0] == 3*(index+1) );
+        REQUIRE( field_read[1] == 1 );
+        REQUIRE( field_read[9] == 0 );
+    }
+
+    ovf_close(file);
+}
+
+TEST_CASE( "Sidecar index", "[sidecar]" )
+{
+    const char * testfile = "testfile_cpp_sidecar.ovf";
+    const char * sidecar  = "testfile_cpp_sidecar.ovfidx";
+    std::remove(sidecar);
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4;
+
+    // data
+    std::vector<double> field(3*segment->N, 1);
+
+    SECTION( "write creates the sidecar" )
+    {
+        std::remove(testfile);
+        auto file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX);
+        field[0] = 3;
+        REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        // the sidecar is only written once, when the file is closed
+        REQUIRE( !std::ifstream(sidecar).good() );
+        ovf_close(file);
+        REQUIRE( std::ifstream(sidecar).good() );
+
+        file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX | OVF_OPEN_LAZY);
+        REQUIRE( file->n_segments == 2 );
+        ovf_close(file);
+    }
+
+    SECTION( "open creates the sidecar and reopen uses it" )
+    {
+        auto file = ovf_open(testfile);
+        field[0] = 3;
+        REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        field[0] = 6;
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+        ovf_close(file);
+        REQUIRE( !std::ifstream(sidecar).good() );
+
+        for( int i = 0; i < 2; ++i )
+        {
+            file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX);
+            REQUIRE( std::ifstream(sidecar).good() );
+            REQUIRE( file->is_ovf == true );
+            REQUIRE( file->n_segments == 2 );
+
+            auto segment_read = ovf_segment_create();
+            REQUIRE( ovf_read_segment_header(file, 1, segment_read) == OVF_OK );
+            REQUIRE( segment_read->N == 4 );
+            std::vector<double> field_read(3*segment_read->N);
+            REQUIRE( ovf_read_segment_data_8(file, 1, segment_read, field_read.data()) == OVF_OK );
+            REQUIRE( field_read[0] == 6 );
+            ovf_close(file);
+        }
+    }
+
+    SECTION( "sidecar holds the segment headers" )
+    {
+        segment->title = const_cast<char *>("sidecar title");
+        segment->comment = const_cast<char *>("sidecar comment");
+        segment->bounds_max[0] = 0.1f;
+        segment->step_size[1] = 1e-9f;
+        auto file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX);
+        REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        auto segment_parsed = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, 0, segment_parsed) == OVF_OK );
+        ovf_close(file);
+
+        std::ifstream in(sidecar, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        REQUIRE( contents.str().find("sidecar titlesidecar comment") != std::string::npos );
+
+        // the header is taken from the sidecar, with the same fields as parsing it
+        file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX);
+        auto segment_read = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, 0, segment_read) == OVF_OK );
+        REQUIRE( std::string(segment_read->title) == "sidecar title" );
+        REQUIRE( std::string(segment_read->comment) == "sidecar comment" );
+        REQUIRE( std::string(segment_read->meshtype) == std::string(segment_parsed->meshtype) );
+        REQUIRE( std::string(segment_read->meshunit) == std::string(segment_parsed->meshunit) );
+        REQUIRE( std::string(segment_read->valueunits) == std::string(segment_parsed->valueunits) );
+        REQUIRE( std::string(segment_read->valuelabels) == std::string(segment_parsed->valuelabels) );
+        REQUIRE( segment_read->valuedim == 3 );
+        REQUIRE( segment_read->N == 4 );
+        for( int dim = 0; dim < 3; ++dim )
+        {
+            REQUIRE( segment_read->n_cells[dim] == segment_parsed->n_cells[dim] );
+            REQUIRE( segment_read->bounds_min[dim] == segment_parsed->bounds_min[dim] );
+            REQUIRE( segment_read->bounds_max[dim] == segment_parsed->bounds_max[dim] );
+            REQUIRE( segment_read->origin[dim] == segment_parsed->origin[dim] );
+            REQUIRE( segment_read->step_size[dim] == segment_parsed->step_size[dim] );
+        }
+
+        // a segment of a different mesh type cannot be read into it
+        segment_read->meshtype = const_cast<char *>("irregular");
+        REQUIRE( ovf_read_segment_header(file, 0, segment_read) == OVF_ERROR );
+        ovf_close(file);
+    }
+
+    SECTION( "stale sidecar is ignored" )
+    {
+        auto file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX);
+        field[0] = 3;
+        REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        ovf_close(file);
+
+        // Append without updating the sidecar
+        file = ovf_open(testfile);
+        field[0] = 9;
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+        ovf_close(file);
+
+        file = ovf_open_flags(testfile, OVF_OPEN_SIDECAR_INDEX);
+        REQUIRE( file->is_ovf == true );
+        REQUIRE( file->n_segments == 2 );
+        auto segment_read = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, 1, segment_read) == OVF_OK );
+        std::vector<double> field_read(3*segment_read->N);
+        REQUIRE( ovf_read_segment_data_8(file, 1, segment_read, field_read.data()) == OVF_OK );
+        REQUIRE( field_read[0] == 9 );
+        ovf_close(file);
+    }
+}
+
+TEST_CASE( "Lazy open", "[lazy]" )
+{
+    const char * testfile = "testfile_cpp_lazy.ovf";
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4;
+
+    // data
+    std::vector<double> field(3*segment->N, 1);
+
+    auto file = ovf_open(testfile);
+    field[0] = 0;
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    field[0] = 1;
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    field[0] = 2;
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    ovf_close(file);
+
+    file = ovf_open_flags(testfile, OVF_OPEN_LAZY);
+    REQUIRE( file->found == true );
+    REQUIRE( file->is_ovf == true );
+    REQUIRE( file->n_segments == 3 );
+
+    // segments are located on demand, in any order
+    for( int index : {2, 0, 1} )
+    {
+        auto segment_read = ovf_segment_create();
+        int success = ovf_read_segment_header(file, index, segment_read);
+        if( OVF_OK != success )
+            std::cerr << ovf_latest_message(file) << std::endl;
+        REQUIRE( success == OVF_OK );
+        REQUIRE( segment_read->N == 4 );
+
+        std::vector<double> field_read(3*segment_read->N);
+        success = ovf_read_segment_data_8(file, index, segment_read, field_read.data());
+        if( OVF_OK != success )
+            std::cerr << ovf_latest_message(file) << std::endl;
+        REQUIRE( success == OVF_OK );
+        REQUIRE( field_read[0] == index );
+        REQUIRE( field_read[1] == 1 );
+    }
+
+    // appending to a lazily opened file
+    field[0] = 3;
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+    REQUIRE( file->n_segments == 4 );
+    std::vector<double> field_read(3*segment->N);
+    REQUIRE( ovf_read_segment_data_8(file, 3, segment, field_read.data()) == OVF_OK );
+    REQUIRE( field_read[0] == 3 );
+    ovf_close(file);
+}
+
+TEST_CASE( "Text data formatting", "[textdata]" )
+{
+    const char * testfile = "testfile_cpp_textdata.ovf";
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4;
+
+    std::vector<double> field(3*segment->N, 0);
+    std::vector<double> expected{ 1, 2, 3, 45, -0.5, 6, 0.5, 7, 8, 9, 1e-3, 11 };
+
+    // Replace the data block written by the library with hand-written data
+    auto write_with_data = [&]( int format, const std::string & begin, const std::string & data )
+    {
+        auto file = ovf_open(testfile);
+        REQUIRE( ovf_write_segment_8(file, segment, field.data(), format) == OVF_OK );
+        ovf_close(file);
+
+        std::ifstream in(testfile, std::ios::binary);
+        std::string contents( (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>() );
+        in.close();
+        std::size_t data_begin = contents.find(begin) + begin.size();
+        std::size_t data_end   = contents.find("# End: Data");
+        contents = contents.substr(0, data_begin) + data + contents.substr(data_end);
+
+        std::ofstream out(testfile, std::ios::binary | std::ios::trunc);
+        out << contents;
+    };
+
+    auto read_data = [&]()
+    {
+        auto file = ovf_open(testfile);
+        auto segment_read = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, 0, segment_read) == OVF_OK );
+        std::vector<double> field_read(3*segment_read->N);
+        int success = ovf_read_segment_data_8(file, 0, segment_read, field_read.data());
+        if( OVF_OK != success )
+            std::cerr << ovf_latest_message(file) << std::endl;
+        ovf_close(file);
+        REQUIRE( success == OVF_OK );
+        return field_read;
+    };
+
+    SECTION( "text" )
+    {
+        write_with_data( OVF_FORMAT_TEXT, "# Begin: Data Text\n",
+            "1 2 3\n"
+            "\t4.5e1\t-5E-1 +6.   \n"
+            "  .5   7 8\r\n"
+            "                     9.000000000000          0.001000000000         11.000000000000\n" );
+        REQUIRE( read_data() == expected );
+    }
+
+    SECTION( "csv" )
+    {
+        write_with_data( OVF_FORMAT_CSV, "# Begin: Data CSV\n",
+            "1,2,3\n"
+            "4.5e1 , -5E-1,+6.,\n"
+            "  .5,   7,8  ,  \r\n"
+            "9.000000000000,0.001000000000,11.000000000000,\n" );
+        REQUIRE( read_data() == expected );
+    }
+
+    SECTION( "invalid" )
+    {
+        write_with_data( OVF_FORMAT_TEXT, "# Begin: Data Text\n",
+            "1 2 3\n"
+            "4 5 x\n"
+            "7 8 9\n"
+            "10 11 12\n" );
+        auto file = ovf_open(testfile);
+        auto segment_read = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, 0, segment_read) == OVF_OK );
+        std::vector<double> field_read(3*segment_read->N);
+        REQUIRE( ovf_read_segment_data_8(file, 0, segment_read, field_read.data()) != OVF_OK );
+        ovf_close(file);
+    }
+}
+
+TEST_CASE( "Text output", "[textoutput]" )
+{
+    const char * testfile = "testfile_cpp_textoutput.ovf";
+
+    // segment header
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 1;
+    segment->n_cells[2] = 1;
+    segment->N = 2;
+
+    // includes a rounding tie (2^-13 * 10^12 = 122070312.5), negative zero and a value too large for a fixed width
+    std::vector<double> field{ 1.5, -0.0, 0.0001220703125, -1e-14, 1e30, 123456.000000000001 };
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+    ovf_close(file);
+
+    std::ifstream in(testfile, std::ios::binary);
+    std::string contents( (std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>() );
+    REQUIRE( contents.find(
+        "# Begin: Data CSV\n"
+        "        1.500000000000,       -0.000000000000,        0.000122070312,\n"
+        "       -0.000000000000,1000000000000000019884624838656.000000000000,   123456.000000000000,\n"
+        "# End: Data CSV\n" ) != std::string::npos );
+}
+
+TEST_CASE( "Threaded text output", "[threads]" )
+{
+    const char * testfile_serial   = "testfile_cpp_threads_1.ovf";
+    const char * testfile_threaded = "testfile_cpp_threads_3.ovf";
+
+    auto read_file = []( const char * filename )
+    {
+        std::ifstream in(filename, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    };
+
+    const int n_cols = 3;
+    const int n_rows = 300;
+    std::vector<double> field(n_cols*n_rows);
+    for( std::size_t i = 0; i < field.size(); ++i )
+        field[i] = ( i % 1000 ) * 0.001 - 0.5;
+
+    SECTION( "several chunks per thread" )
+    {
+        auto write_data = [&]( const char * filename, const std::string & delimiter, int n_threads, int rows_per_chunk )
+        {
+            ovf::detail::io::file_writer writer;
+            REQUIRE( writer.open(filename, false) );
+            {
+                ovf::detail::write::file_handle handle(writer, filename);
+                ovf::detail::write::write_data_txt( handle, field.data(), n_cols, n_rows, delimiter, n_threads, rows_per_chunk );
+                handle.flush();
+            }
+            writer.close();
+            return read_file(filename);
+        };
+
+        for( std::string delimiter : { "", "," } )
+        {
+            std::string serial = write_data( testfile_serial, delimiter, 1, 0 );
+            // more chunks than buffers, a last chunk which is not full and a single row per chunk
+            for( int n_threads : { 3, 4 } )
+                for( int rows_per_chunk : { 7, 1 } )
+                    REQUIRE( write_data(testfile_threaded, delimiter, n_threads, rows_per_chunk) == serial );
+        }
+    }
+
+    SECTION( "set through the file" )
+    {
+        auto segment = ovf_segment_create();
+        segment->valuedim = n_cols;
+        segment->n_cells[0] = 10;
+        segment->n_cells[1] = 10;
+        segment->n_cells[2] = 3;
+        segment->N = n_rows;
+
+        for( int format : { OVF_FORMAT_TEXT, OVF_FORMAT_CSV } )
+        {
+            auto file = ovf_open(testfile_serial);
+            REQUIRE( ovf_set_write_threads(file, 1) == OVF_OK );
+            REQUIRE( ovf_write_segment_8(file, segment, field.data(), format) == OVF_OK );
+            ovf_close(file);
+
+            file = ovf_open(testfile_threaded);
+            REQUIRE( ovf_set_write_threads(file, -1) == OVF_ERROR );
+            REQUIRE( ovf_set_write_threads(file, 3) == OVF_OK );
+            REQUIRE( ovf_write_segment_8(file, segment, field.data(), format) == OVF_OK );
+            ovf_close(file);
+
+            REQUIRE( read_file(testfile_serial) == read_file(testfile_threaded) );
+        }
+    }
+
+    std::remove(testfile_serial);
+    std::remove(testfile_threaded);
+}
+
+TEST_CASE( "Repeated appends", "[appends]" )
+{
+    const char * testfile = "testfile_cpp_appends.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 2;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4;
+
+    std::vector<double> field(3*segment->N);
+
+    auto file = ovf_open(testfile);
+    for( int i = 0; i < 50; ++i )
+    {
+        field[0] = i;
+        if( i == 0 )
+            REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        else
+            REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    }
+    REQUIRE( file->n_segments == 50 );
+
+    // the segment count and the segments are readable while the file is still open for writing
+    auto reader = ovf_open(testfile);
+    REQUIRE( reader->n_segments == 50 );
+    REQUIRE( ovf_read_segment_data_8(reader, 49, segment, field.data()) == OVF_OK );
+    REQUIRE( field[0] == 49 );
+    ovf_close(reader);
+
+    // overwriting starts the count from scratch
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    REQUIRE( file->n_segments == 2 );
+    ovf_close(file);
+
+    file = ovf_open(testfile);
+    REQUIRE( file->n_segments == 2 );
+    REQUIRE( ovf_read_segment_data_8(file, 1, segment, field.data()) == OVF_OK );
+    REQUIRE( field[0] == 49 );
+    ovf_close(file);
+}
+
+TEST_CASE( "Writer", "[writer]" )
+{
+    const char * testfile = "testfile_cpp_writer.ovf";
+    const char * testfile_reference = "testfile_cpp_writer_reference.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->title = const_cast<char *>("frame");
+    segment->valuedim = 3;
+    segment->n_cells[0] = 4;
+    segment->n_cells[1] = 3;
+    segment->n_cells[2] = 2;
+    segment->N = 4*3*2;
+
+    std::vector<double> field(3*segment->N, 0.25);
+    std::remove(testfile);
+
+    SECTION( "invalid" )
+    {
+        REQUIRE( ovf_writer_open(testfile, segment, 17) == nullptr );
+        REQUIRE( ovf_writer_open(testfile, nullptr, OVF_FORMAT_BIN) == nullptr );
+        REQUIRE( ovf_writer_append_8(nullptr, field.data()) == OVF_ERROR );
+    }
+
+    SECTION( "same output as appending" )
+    {
+        for( int format : { OVF_FORMAT_BIN8, OVF_FORMAT_CSV } )
+        {
+            auto writer = ovf_writer_open(testfile, segment, format);
+            REQUIRE( writer != nullptr );
+            auto file = ovf_open(testfile_reference);
+            for( int i = 0; i < 3; ++i )
+            {
+                field[0] = i;
+                REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_OK );
+                if( i == 0 )
+                    REQUIRE( ovf_write_segment_8(file, segment, field.data(), format) == OVF_OK );
+                else
+                    REQUIRE( ovf_append_segment_8(file, segment, field.data(), format) == OVF_OK );
+            }
+            REQUIRE( ovf_writer_append_8(writer, nullptr) == OVF_ERROR );
+            REQUIRE( std::string(ovf_writer_latest_message(writer)) != "" );
+            REQUIRE( ovf_writer_close(writer) == OVF_OK );
+            ovf_close(file);
+
+            std::ifstream in(testfile, std::ios::binary), in_reference(testfile_reference, std::ios::binary);
+            std::stringstream contents, contents_reference;
+            contents << in.rdbuf();
+            contents_reference << in_reference.rdbuf();
+            REQUIRE( contents.str() == contents_reference.str() );
+            std::remove(testfile);
+        }
+    }
+
+    SECTION( "asynchronous" )
+    {
+        auto writer = ovf_writer_open(testfile, segment, OVF_FORMAT_TEXT);
+        REQUIRE( ovf_writer_set_async(writer, 2) == OVF_OK );
+        auto file = ovf_open(testfile_reference);
+        for( int i = 0; i < 20; ++i )
+        {
+            // the data is copied, so it can be changed as soon as appending returns
+            field[0] = i;
+            REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_OK );
+            if( i == 0 )
+                REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+            else
+                REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+        }
+        REQUIRE( ovf_writer_wait(writer) == OVF_OK );
+        REQUIRE( ovf_writer_set_async(writer, 0) == OVF_OK );
+        REQUIRE( ovf_writer_close(writer) == OVF_OK );
+        ovf_close(file);
+
+        std::ifstream in(testfile, std::ios::binary), in_reference(testfile_reference, std::ios::binary);
+        std::stringstream contents, contents_reference;
+        contents << in.rdbuf();
+        contents_reference << in_reference.rdbuf();
+        REQUIRE( contents.str() == contents_reference.str() );
+    }
+
+    SECTION( "asynchronous error" )
+    {
+        auto writer = ovf_writer_open("nonexistent_directory/testfile_cpp_writer.ovf", segment, OVF_FORMAT_BIN);
+        REQUIRE( writer != nullptr );
+        REQUIRE( ovf_writer_set_async(writer, 2) == OVF_OK );
+        REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_OK );
+        REQUIRE( ovf_writer_wait(writer) == OVF_ERROR );
+        REQUIRE( std::string(ovf_writer_latest_message(writer)) != "" );
+        // nothing is accepted after an error
+        REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_ERROR );
+        REQUIRE( ovf_writer_close(writer) == OVF_OK );
+    }
+
+    SECTION( "append to an existing file" )
+    {
+        auto writer = ovf_writer_open(testfile, segment, OVF_FORMAT_BIN);
+        REQUIRE( ovf_writer_append_4(writer, std::vector<float>(3*segment->N, 1).data()) == OVF_OK );
+        REQUIRE( ovf_writer_close(writer) == OVF_OK );
+
+        writer = ovf_writer_open(testfile, segment, OVF_FORMAT_TEXT);
+        REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_OK );
+        REQUIRE( ovf_writer_close(writer) == OVF_OK );
+
+        auto file = ovf_open(testfile);
+        REQUIRE( file->n_segments == 2 );
+        std::vector<float> data(3*segment->N);
+        REQUIRE( ovf_read_segment_data_4(file, 0, segment, data.data()) == OVF_OK );
+        REQUIRE( data[5] == 1 );
+        REQUIRE( ovf_read_segment_data_4(file, 1, segment, data.data()) == OVF_OK );
+        REQUIRE( data[5] == 0.25 );
+        ovf_close(file);
+    }
+}
+
+TEST_CASE( "Recovery", "[recover]" )
+{
+    const char * testfile = "testfile_cpp_recover.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 3;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 6;
+
+    std::vector<double> field(3*segment->N, 0);
+
+    auto read_file = [&]()
+    {
+        std::ifstream in(testfile, std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    };
+    auto write_file = [&]( const std::string & contents )
+    {
+        std::ofstream out(testfile, std::ios::binary | std::ios::trunc);
+        out << contents;
+    };
+
+    // three segments, synced on every segment
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_set_sync_interval(file, -1) == OVF_ERROR );
+    REQUIRE( ovf_set_sync_interval(file, 1) == OVF_OK );
+    for( int i = 0; i < 3; ++i )
+    {
+        field[0] = i;
+        if( i == 0 )
+            REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        else
+            REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+    }
+    REQUIRE( ovf_close(file) == OVF_OK );
+    std::string contents = read_file();
+    std::string count = "# Segment count: 000003";
+    REQUIRE( contents.find(count) != std::string::npos );
+
+    SECTION( "count behind the segments" )
+    {
+        // interrupted after the last segment was written, but before the count was updated
+        contents.replace( contents.find(count), count.size(), "# Segment count: 000002" );
+        write_file(contents);
+
+        file = ovf_open(testfile);
+        REQUIRE( file->is_ovf );
+        REQUIRE( file->n_segments == 3 );
+        REQUIRE( ovf_read_segment_data_8(file, 2, segment, field.data()) == OVF_OK );
+        REQUIRE( field[0] == 2 );
+        field[0] = 3;
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        ovf_close(file);
+
+        file = ovf_open(testfile);
+        REQUIRE( file->n_segments == 4 );
+        ovf_close(file);
+    }
+
+    SECTION( "incomplete last segment" )
+    {
+        // interrupted while writing the last segment, after the count was updated
+        std::size_t last = contents.rfind("#\n# Begin: Segment");
+        contents += contents.substr( last, ( contents.size() - last ) / 2 );
+        contents.replace( contents.find(count), count.size(), "# Segment count: 000004" );
+        write_file(contents);
+
+        file = ovf_open(testfile);
+        REQUIRE( !file->is_ovf );
+        ovf_close(file);
+
+        file = ovf_open_flags(testfile, OVF_OPEN_RECOVER);
+        REQUIRE( file->is_ovf );
+        REQUIRE( file->n_segments == 3 );
+        REQUIRE( std::string(ovf_latest_message(file)) != "" );
+        REQUIRE( ovf_set_sync_interval(file, 2) == OVF_OK );
+        field[0] = 3;
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( ovf_close(file) == OVF_OK );
+
+        // the incomplete segment was cut off
+        file = ovf_open(testfile);
+        REQUIRE( file->is_ovf );
+        REQUIRE( file->n_segments == 4 );
+        REQUIRE( ovf_read_segment_data_8(file, 3, segment, field.data()) == OVF_OK );
+        REQUIRE( field[0] == 3 );
+        ovf_close(file);
+    }
+
+    SECTION( "count behind the segments, appending lazily" )
+    {
+        // e.g. a crash with a sync interval, before the count was updated at the next sync point
+        contents.replace( contents.find(count), count.size(), "# Segment count: 000001" );
+        write_file(contents);
+
+        file = ovf_open_flags(testfile, OVF_OPEN_LAZY);
+        REQUIRE( file->is_ovf );
+        field[0] = 3;
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( file->n_segments == 4 );
+        REQUIRE( ovf_close(file) == OVF_OK );
+        REQUIRE( read_file().find("# Segment count: 000004") != std::string::npos );
+
+        file = ovf_open_flags(testfile, OVF_OPEN_LAZY);
+        REQUIRE( file->n_segments == 4 );
+        REQUIRE( ovf_read_segment_data_8(file, 3, segment, field.data()) == OVF_OK );
+        REQUIRE( field[0] == 3 );
+        ovf_close(file);
+    }
+
+    SECTION( "count updated at sync points" )
+    {
+        file = ovf_open(testfile);
+        REQUIRE( ovf_set_sync_interval(file, 2) == OVF_OK );
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( file->n_segments == 4 );
+
+        // the segment is not synced yet, so the count in the file does not include it
+        REQUIRE( read_file().find(count) != std::string::npos );
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( read_file().find("# Segment count: 000005") != std::string::npos );
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( read_file().find("# Segment count: 000005") != std::string::npos );
+
+        // uncounted segments are found by readers
+        auto reader = ovf_open(testfile);
+        REQUIRE( reader->n_segments == 6 );
+        ovf_close(reader);
+
+        // closing syncs and counts the remaining segments
+        REQUIRE( ovf_close(file) == OVF_OK );
+        REQUIRE( read_file().find("# Segment count: 000006") != std::string::npos );
+    }
+
+    SECTION( "incomplete last segment, count not updated" )
+    {
+        // interrupted while writing the last segment, before the count was updated
+        std::size_t last = contents.rfind("#\n# Begin: Segment");
+        contents += contents.substr( last, ( contents.size() - last ) / 2 );
+        write_file(contents);
+
+        file = ovf_open(testfile);
+        REQUIRE( file->is_ovf );
+        REQUIRE( file->n_segments == 3 );
+        REQUIRE( std::string(ovf_latest_message(file)) != "" );
+        field[0] = 3;
+        REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN) == OVF_OK );
+        REQUIRE( ovf_close(file) == OVF_OK );
+
+        // the incomplete segment was cut off
+        file = ovf_open(testfile);
+        REQUIRE( file->is_ovf );
+        REQUIRE( file->n_segments == 4 );
+        auto header = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, 3, header) == OVF_OK );
+        REQUIRE( ovf_read_segment_data_8(file, 3, segment, field.data()) == OVF_OK );
+        REQUIRE( field[0] == 3 );
+        ovf_close(file);
+    }
+
+    SECTION( "incomplete last segment, appending lazily" )
+    {
+        std::size_t last = contents.rfind("#\n# Begin: Segment");
+        contents += contents.substr( last, ( contents.size() - last ) / 2 );
+        write_file(contents);
+
+        // the writer opens the file lazily, so the incomplete segment is only found when appending
+        auto writer = ovf_writer_open(testfile, segment, OVF_FORMAT_BIN);
+        REQUIRE( writer );
+        field[0] = 3;
+        REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_OK );
+        field[0] = 4;
+        REQUIRE( ovf_writer_append_8(writer, field.data()) == OVF_OK );
+        REQUIRE( ovf_writer_close(writer) == OVF_OK );
+
+        file = ovf_open(testfile);
+        REQUIRE( file->is_ovf );
+        REQUIRE( file->n_segments == 5 );
+        REQUIRE( ovf_read_segment_data_8(file, 3, segment, field.data()) == OVF_OK );
+        REQUIRE( field[0] == 3 );
+        REQUIRE( ovf_read_segment_data_8(file, 4, segment, field.data()) == OVF_OK );
+        REQUIRE( field[0] == 4 );
+        ovf_close(file);
+    }
+}
+
+TEST_CASE( "Region", "[region]" )
+{
+    const char * testfile = "testfile_cpp_region.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 2;
+    segment->n_cells[0] = 5;
+    segment->n_cells[1] = 4;
+    segment->n_cells[2] = 3;
+    segment->N = 5*4*3;
+
+    // the values encode the cell and component
+    std::vector<double> field(2*segment->N);
+    for( int z = 0; z < 3; ++z )
+        for( int y = 0; y < 4; ++y )
+            for( int x = 0; x < 5; ++x )
+                for( int c = 0; c < 2; ++c )
+                    field[c + 2*( x + 5*( y + 4*z ) )] = 1000*z + 100*y + 10*x + c;
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN8) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN4) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+    ovf_close(file);
+
+    const int lo[3] = {1, 2, 0};
+    const int hi[3] = {4, 4, 2};
+    std::vector<double> expected;
+    for( int z = lo[2]; z < hi[2]; ++z )
+        for( int y = lo[1]; y < hi[1]; ++y )
+            for( int x = lo[0]; x < hi[0]; ++x )
+                for( int c = 0; c < 2; ++c )
+                    expected.push_back( 1000*z + 100*y + 10*x + c );
+
+    file = ovf_open(testfile);
+    for( int index = 0; index < 4; ++index )
+    {
+        std::vector<double> region(expected.size());
+        REQUIRE( ovf_read_segment_region_8(file, index, segment, lo, hi, region.data()) == OVF_OK );
+        REQUIRE( region == expected );
+
+        std::vector<float> region_4(expected.size());
+        REQUIRE( ovf_read_segment_region_4(file, index, segment, lo, hi, region_4.data()) == OVF_OK );
+        REQUIRE( region_4 == std::vector<float>(expected.begin(), expected.end()) );
+    }
+
+    // the whole segment
+    const int all_lo[3] = {0, 0, 0};
+    std::vector<double> all(field.size());
+    REQUIRE( ovf_read_segment_region_8(file, 2, segment, all_lo, segment->n_cells, all.data()) == OVF_OK );
+    REQUIRE( all == field );
+
+    // invalid regions and shapes
+    const int empty_hi[3] = {1, 4, 2};
+    const int large_hi[3] = {4, 5, 2};
+    REQUIRE( ovf_read_segment_region_8(file, 0, segment, lo, empty_hi, all.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segment_region_8(file, 0, segment, lo, large_hi, all.data()) == OVF_ERROR );
+    segment->n_cells[0] = 4;
+    REQUIRE( ovf_read_segment_region_8(file, 0, segment, lo, hi, all.data()) == OVF_INVALID );
+    ovf_close(file);
+}
+
+TEST_CASE( "Segments", "[segments]" )
+{
+    const char * testfile = "testfile_cpp_segments.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 4;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 4*2;
+
+    // the values encode the segment, cell and component
+    const int n_frames = 5;
+    const int formats[n_frames] = { OVF_FORMAT_BIN8, OVF_FORMAT_BIN4, OVF_FORMAT_TEXT, OVF_FORMAT_CSV, OVF_FORMAT_BIN8 };
+    std::vector<double> series(n_frames*3*segment->N);
+    for( int i = 0; i < int(series.size()); ++i )
+        series[i] = i;
+
+    auto file = ovf_open(testfile);
+    for( int frame = 0; frame < n_frames; ++frame )
+    {
+        double * frame_data = series.data() + frame*3*segment->N;
+        if( frame == 0 )
+            REQUIRE( ovf_write_segment_8(file, segment, frame_data, formats[frame]) == OVF_OK );
+        else
+            REQUIRE( ovf_append_segment_8(file, segment, frame_data, formats[frame]) == OVF_OK );
+    }
+    // a segment of a different shape
+    segment->n_cells[0] = 2;
+    segment->N = 2*2;
+    REQUIRE( ovf_append_segment_8(file, segment, series.data(), OVF_FORMAT_BIN8) == OVF_OK );
+    segment->n_cells[0] = 4;
+    segment->N = 4*2;
+    ovf_close(file);
+
+    file = ovf_open(testfile);
+    std::vector<double> all(series.size());
+    REQUIRE( ovf_read_segments_8(file, 0, n_frames, segment, all.data()) == OVF_OK );
+    REQUIRE( all == series );
+
+    std::vector<float> some(2*3*segment->N);
+    REQUIRE( ovf_read_segments_4(file, 2, 2, segment, some.data()) == OVF_OK );
+    REQUIRE( some == std::vector<float>(series.begin() + 2*3*segment->N, series.begin() + 4*3*segment->N) );
+
+    // invalid ranges and shapes
+    REQUIRE( ovf_read_segments_8(file, -1, 2, segment, all.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segments_8(file, 0, 0, segment, all.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segments_8(file, 4, 3, segment, all.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segments_8(file, 4, 2, segment, all.data()) == OVF_INVALID );
+    ovf_close(file);
+}
+
+TEST_CASE( "Range", "[range]" )
+{
+    const char * testfile = "testfile_cpp_range.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 10;
+    segment->n_cells[1] = 2;
+    segment->n_cells[2] = 1;
+    segment->N = 10*2;
+
+    // the values encode the cell and component
+    std::vector<double> field(3*segment->N);
+    for( int cell = 0; cell < segment->N; ++cell )
+        for( int c = 0; c < 3; ++c )
+            field[c + 3*cell] = 10*cell + c;
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN8) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN4) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+    ovf_close(file);
+
+    file = ovf_open(testfile);
+    for( int index = 0; index < 4; ++index )
+    {
+        std::vector<double> range(3*5);
+        REQUIRE( ovf_read_segment_range_8(file, index, segment, 7, 5, range.data()) == OVF_OK );
+        REQUIRE( range == std::vector<double>(field.begin() + 3*7, field.begin() + 3*12) );
+
+        std::vector<float> range_4(3*5);
+        REQUIRE( ovf_read_segment_range_4(file, index, segment, 15, 5, range_4.data()) == OVF_OK );
+        REQUIRE( range_4 == std::vector<float>(field.begin() + 3*15, field.end()) );
+
+        // partial read of the first cells
+        auto partial = ovf_segment_create();
+        REQUIRE( ovf_read_segment_header(file, index, partial) == OVF_OK );
+        partial->N = 3;
+        std::vector<double> first(3*partial->N + 1, -1);
+        REQUIRE( ovf_read_segment_data_8(file, index, partial, first.data()) == OVF_OK );
+        REQUIRE( std::vector<double>(first.begin(), first.end() - 1) == std::vector<double>(field.begin(), field.begin() + 9) );
+        REQUIRE( first.back() == -1 );
+    }
+
+    // invalid ranges
+    std::vector<double> range(field.size());
+    REQUIRE( ovf_read_segment_range_8(file, 0, segment, -1, 2, range.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segment_range_8(file, 0, segment, 0, 0, range.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segment_range_8(file, 0, segment, 15, 6, range.data()) == OVF_ERROR );
+    segment->valuedim = 1;
+    REQUIRE( ovf_read_segment_range_8(file, 0, segment, 0, 1, range.data()) == OVF_INVALID );
+    ovf_close(file);
+}
+
+TEST_CASE( "Strided", "[strided]" )
+{
+    const char * testfile = "testfile_cpp_strided.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 2;
+    segment->n_cells[0] = 7;
+    segment->n_cells[1] = 5;
+    segment->n_cells[2] = 3;
+    segment->N = 7*5*3;
+
+    // the values encode the cell and component
+    std::vector<double> field(2*segment->N);
+    for( int z = 0; z < 3; ++z )
+        for( int y = 0; y < 5; ++y )
+            for( int x = 0; x < 7; ++x )
+                for( int c = 0; c < 2; ++c )
+                    field[c + 2*( x + 7*( y + 5*z ) )] = 1000*z + 100*y + 10*x + c;
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN8) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN4) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+    ovf_close(file);
+
+    file = ovf_open(testfile);
+    const int strides[][3] = { {3, 2, 2}, {1, 4, 1}, {8, 8, 8} };
+    for( const auto & stride : strides )
+    {
+        std::vector<double> expected;
+        for( int z = 0; z < 3; z += stride[2] )
+            for( int y = 0; y < 5; y += stride[1] )
+                for( int x = 0; x < 7; x += stride[0] )
+                    for( int c = 0; c < 2; ++c )
+                        expected.push_back( 1000*z + 100*y + 10*x + c );
+
+        for( int index = 0; index < 4; ++index )
+        {
+            std::vector<double> preview(expected.size());
+            REQUIRE( ovf_read_segment_strided_8(file, index, segment, stride, preview.data()) == OVF_OK );
+            REQUIRE( preview == expected );
+
+            std::vector<float> preview_4(expected.size());
+            REQUIRE( ovf_read_segment_strided_4(file, index, segment, stride, preview_4.data()) == OVF_OK );
+            REQUIRE( preview_4 == std::vector<float>(expected.begin(), expected.end()) );
+        }
+    }
+
+    // stride 1 reads the whole segment
+    const int ones[3] = {1, 1, 1};
+    std::vector<double> all(field.size());
+    REQUIRE( ovf_read_segment_strided_8(file, 3, segment, ones, all.data()) == OVF_OK );
+    REQUIRE( all == field );
+
+    // invalid strides and shapes
+    const int zero[3] = {1, 0, 1};
+    REQUIRE( ovf_read_segment_strided_8(file, 0, segment, zero, all.data()) == OVF_ERROR );
+    segment->n_cells[0] = 5;
+    REQUIRE( ovf_read_segment_strided_8(file, 0, segment, ones, all.data()) == OVF_INVALID );
+    ovf_close(file);
+}
+
+TEST_CASE( "Components", "[components]" )
+{
+    const char * testfile = "testfile_cpp_components.ovf";
+
+    auto segment = ovf_segment_create();
+    segment->valuedim = 3;
+    segment->n_cells[0] = 7;
+    segment->n_cells[1] = 3;
+    segment->n_cells[2] = 1;
+    segment->N = 7*3;
+
+    // the values encode the cell and component
+    std::vector<double> field(3*segment->N);
+    for( int cell = 0; cell < segment->N; ++cell )
+        for( int c = 0; c < 3; ++c )
+            field[c + 3*cell] = 10*cell + c;
+
+    auto file = ovf_open(testfile);
+    REQUIRE( ovf_write_segment_8(file, segment, field.data(), OVF_FORMAT_BIN8) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_BIN4) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_TEXT) == OVF_OK );
+    REQUIRE( ovf_append_segment_8(file, segment, field.data(), OVF_FORMAT_CSV) == OVF_OK );
+    ovf_close(file);
+
+    file = ovf_open(testfile);
+    for( int index = 0; index < 4; ++index )
+    {
+        // only z
+        std::vector<double> z(segment->N);
+        REQUIRE( ovf_read_segment_components_8(file, index, segment, 0b100, z.data()) == OVF_OK );
+        for( int cell = 0; cell < segment->N; ++cell )
+            REQUIRE( z[cell] == 10*cell + 2 );
+
+        // x and z, packed
+        std::vector<float> xz(2*segment->N);
+        REQUIRE( ovf_read_segment_components_4(file, index, segment, 0b101, xz.data()) == OVF_OK );
+        for( int cell = 0; cell < segment->N; ++cell )
+        {
+            REQUIRE( xz[2*cell]   == 10*cell );
+            REQUIRE( xz[2*cell+1] == 10*cell + 2 );
+        }
+
+        // all components
+        std::vector<double> all(3*segment->N);
+        REQUIRE( ovf_read_segment_components_8(file, index, segment, 0b111, all.data()) == OVF_OK );
+        REQUIRE( all == field );
+    }
+
+    // partial read
+    segment->N = 4;
+    std::vector<double> y(4, -1);
+    REQUIRE( ovf_read_segment_components_8(file, 2, segment, 0b010, y.data()) == OVF_OK );
+    REQUIRE( y == std::vector<double>({1, 11, 21, 31}) );
+
+    // invalid masks
+    REQUIRE( ovf_read_segment_components_8(file, 0, segment, 0, y.data()) == OVF_ERROR );
+    REQUIRE( ovf_read_segment_components_8(file, 0, segment, 0b1000, y.data()) == OVF_ERROR );
+    ovf_close(file);
+}